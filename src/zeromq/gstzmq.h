@@ -10,4 +10,54 @@
 #define ZMQ_DEFAULT_ENDPOINT_SERVER "tcp://*:5556"
 #define ZMQ_DEFAULT_ENDPOINT_CLIENT "tcp://localhost:5556"
 
+#define ZMQ_DEFAULT_MAX_MESSAGE_SIZE 0
+
+/* fragmented and compressed payloads announce their size before it can be
+ * checked; without a max-message-size, claims beyond this are refused
+ * rather than allocated */
+#define ZMQ_DEFAULT_MAX_PAYLOAD_SIZE (64 * 1024 * 1024)
+#define ZMQ_DEFAULT_STATS_INTERVAL 0
+#define ZMQ_DEFAULT_STAMP FALSE
+#define ZMQ_DEFAULT_CLOCK_OFFSET 0
+
+#define ZMQ_DEFAULT_MONITOR FALSE
+#define ZMQ_DEFAULT_RECONNECT_IVL 100
+#define ZMQ_DEFAULT_RECONNECT_IVL_MAX 0
+#define ZMQ_DEFAULT_HEARTBEAT_IVL 0
+#define ZMQ_DEFAULT_HEARTBEAT_TIMEOUT 0
+#define ZMQ_DEFAULT_HEARTBEAT_TTL 0
+#define ZMQ_DEFAULT_STALL_TIMEOUT 0
+#define ZMQ_DEFAULT_EOS_ON_STALL FALSE
+
+#define ZMQ_RECEIVE_TIMEOUT_MS 1000
+
+#define ZMQ_DEFAULT_GROUP "gst"
+#define ZMQ_DEFAULT_MULTICAST_RATE 100
+#define ZMQ_DEFAULT_MULTICAST_HOPS 1
+
+/* libzmq's UDP engine sends each message as one datagram of at most this
+ * many bytes, including the group */
+#define ZMQ_RADIO_MAX_DATAGRAM 8192
+
+#define ZMQ_DEFAULT_COMPRESSION_LEVEL 0
+#define ZMQ_DEFAULT_COMPRESSION_BUDGET 0
+
+/* compression that saves less than 1/ZMQ_COMPRESSION_MIN_GAIN of the size
+ * is not worth it, and is then skipped for up to ZMQ_COMPRESSION_MAX_SKIP
+ * messages */
+#define ZMQ_COMPRESSION_MIN_GAIN 8
+#define ZMQ_COMPRESSION_MAX_SKIP 64
+
+#define ZMQ_DEFAULT_STRIPES 1
+#define ZMQ_MAX_STRIPES 16
+
+/* unframed payloads from this size on are sent straight from the buffer's
+ * memory; below it, copying is cheaper than keeping the buffer alive until
+ * ZeroMQ is done with it */
+#define ZMQ_ZERO_COPY_MIN_SIZE 16384
+
+/* messages still queued when zmqsink stops get this many ms to go out, so
+ * destroying the context never hangs on a stuck peer */
+#define ZMQ_SINK_LINGER_MS 1000
+
 #endif // __GST_ZMQ_H_
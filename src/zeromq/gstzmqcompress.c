@@ -0,0 +1,141 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "gstzmqcompress.h"
+#include "gstzmqframing.h"
+
+GST_DEBUG_CATEGORY_EXTERN (zmq_debug);
+#define GST_CAT_DEFAULT zmq_debug
+
+GType
+gst_zmq_compression_get_type (void)
+{
+  static GType compression_type = 0;
+  static const GEnumValue compressions[] = {
+    {GST_ZMQ_COMPRESSION_NONE, "No compression", "none"},
+#ifdef HAVE_LZ4
+    {GST_ZMQ_COMPRESSION_LZ4, "LZ4, fast", "lz4"},
+#endif
+#ifdef HAVE_ZSTD
+    {GST_ZMQ_COMPRESSION_ZSTD, "Zstandard, smaller", "zstd"},
+#endif
+    {0, NULL, NULL}
+  };
+
+  if (!compression_type) {
+    compression_type = g_enum_register_static ("GstZmqCompression",
+        compressions);
+  }
+  return compression_type;
+}
+
+guint8
+gst_zmq_compression_flag (GstZmqCompression compression)
+{
+  switch (compression) {
+    case GST_ZMQ_COMPRESSION_LZ4:
+      return GST_ZMQ_HEADER_FLAG_LZ4;
+    case GST_ZMQ_COMPRESSION_ZSTD:
+      return GST_ZMQ_HEADER_FLAG_ZSTD;
+    default:
+      return 0;
+  }
+}
+
+gsize
+gst_zmq_compress_bound (GstZmqCompression compression, gsize size)
+{
+  switch (compression) {
+#ifdef HAVE_LZ4
+    case GST_ZMQ_COMPRESSION_LZ4:
+      return size > LZ4_MAX_INPUT_SIZE ? 0 : LZ4_compressBound (size);
+#endif
+#ifdef HAVE_ZSTD
+    case GST_ZMQ_COMPRESSION_ZSTD:
+      return ZSTD_compressBound (size);
+#endif
+    default:
+      return 0;
+  }
+}
+
+/* returns the compressed size, or 0 if @src could not be compressed into
+ * @dest_size bytes */
+gsize
+gst_zmq_compress (GstZmqCompression compression, gint level,
+    const guint8 * src, gsize size, guint8 * dest, gsize dest_size)
+{
+  switch (compression) {
+#ifdef HAVE_LZ4
+    case GST_ZMQ_COMPRESSION_LZ4:{
+      int rc = LZ4_compress_default ((const char *) src, (char *) dest, size,
+          dest_size);
+      return rc > 0 ? rc : 0;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    case GST_ZMQ_COMPRESSION_ZSTD:{
+      size_t rc = ZSTD_compress (dest, dest_size, src, size, level);
+      if (ZSTD_isError (rc)) {
+        GST_DEBUG ("ZSTD_compress() failed: %s", ZSTD_getErrorName (rc));
+        return 0;
+      }
+      return rc;
+    }
+#endif
+    default:
+      return 0;
+  }
+}
+
+/* decompresses exactly @dest_size bytes, using the codec named by the
+ * header @flags */
+gboolean
+gst_zmq_decompress (guint8 flags, const guint8 * src, gsize size,
+    guint8 * dest, gsize dest_size)
+{
+#ifdef HAVE_LZ4
+  if (flags & GST_ZMQ_HEADER_FLAG_LZ4) {
+    int rc = LZ4_decompress_safe ((const char *) src, (char *) dest, size,
+        dest_size);
+    return rc >= 0 && (gsize) rc == dest_size;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if (flags & GST_ZMQ_HEADER_FLAG_ZSTD) {
+    size_t rc = ZSTD_decompress (dest, dest_size, src, size);
+    return !ZSTD_isError (rc) && rc == dest_size;
+  }
+#endif
+
+  GST_WARNING ("payload compressed with an unsupported codec (flags 0x%02x)",
+      flags);
+  return FALSE;
+}
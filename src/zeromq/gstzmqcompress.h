@@ -0,0 +1,47 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_ZMQ_COMPRESS_H__
+#define __GST_ZMQ_COMPRESS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_ZMQ_COMPRESSION (gst_zmq_compression_get_type ())
+
+typedef enum {
+  GST_ZMQ_COMPRESSION_NONE,
+  GST_ZMQ_COMPRESSION_LZ4,
+  GST_ZMQ_COMPRESSION_ZSTD
+} GstZmqCompression;
+
+GType gst_zmq_compression_get_type (void);
+
+guint8 gst_zmq_compression_flag (GstZmqCompression compression);
+gsize gst_zmq_compress_bound (GstZmqCompression compression, gsize size);
+gsize gst_zmq_compress (GstZmqCompression compression, gint level,
+    const guint8 * src, gsize size, guint8 * dest, gsize dest_size);
+gboolean gst_zmq_decompress (guint8 flags, const guint8 * src, gsize size,
+    guint8 * dest, gsize dest_size);
+
+G_END_DECLS
+
+#endif /* __GST_ZMQ_COMPRESS_H__ */
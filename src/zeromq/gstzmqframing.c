@@ -0,0 +1,434 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>             // for memcpy
+#include <time.h>               // for clock_gettime
+
+#include "gstzmqframing.h"
+#include "gstzmqstats.h"
+
+GST_DEBUG_CATEGORY_EXTERN (zmq_debug);
+#define GST_CAT_DEFAULT zmq_debug
+
+void
+gst_zmq_header_write (const GstZmqHeader * header, guint8 * data)
+{
+  GST_WRITE_UINT32_BE (data, GST_ZMQ_HEADER_MAGIC);
+  GST_WRITE_UINT8 (data + 4, GST_ZMQ_HEADER_VERSION);
+  GST_WRITE_UINT8 (data + 5, header->flags);
+  GST_WRITE_UINT16_BE (data + 6, GST_ZMQ_HEADER_SIZE);
+  GST_WRITE_UINT64_BE (data + 8, header->seqnum);
+  GST_WRITE_UINT64_BE (data + 16, header->send_time);
+  GST_WRITE_UINT64_BE (data + 24, header->total_size);
+  GST_WRITE_UINT64_BE (data + 32, header->offset);
+  GST_WRITE_UINT64_BE (data + 40, header->raw_size);
+  GST_WRITE_UINT32_BE (data + 48, header->sender);
+  GST_WRITE_UINT16_BE (data + 52, header->stripe);
+  GST_WRITE_UINT16_BE (data + 54, 0);
+}
+
+/* returns FALSE if the message does not start with a header we understand,
+ * in which case the whole message is payload; zmqsink only writes a header
+ * with at least one flag set, so a payload that merely starts with the
+ * magic is very unlikely to pass for one */
+gboolean
+gst_zmq_header_read (GstZmqHeader * header, const guint8 * data, gsize size)
+{
+  guint8 flags;
+
+  if (size < GST_ZMQ_HEADER_SIZE)
+    return FALSE;
+
+  if (GST_READ_UINT32_BE (data) != GST_ZMQ_HEADER_MAGIC
+      || GST_READ_UINT8 (data + 4) != GST_ZMQ_HEADER_VERSION)
+    return FALSE;
+
+  flags = GST_READ_UINT8 (data + 5);
+  if (flags == 0 || (flags & ~GST_ZMQ_HEADER_FLAGS_KNOWN) != 0
+      || (flags & GST_ZMQ_HEADER_FLAG_COMPRESSED) ==
+      GST_ZMQ_HEADER_FLAG_COMPRESSED)
+    return FALSE;
+
+  header->flags = flags;
+  header->header_size = GST_READ_UINT16_BE (data + 6);
+  if (header->header_size < GST_ZMQ_HEADER_SIZE || header->header_size > size)
+    return FALSE;
+
+  header->seqnum = GST_READ_UINT64_BE (data + 8);
+  header->send_time = GST_READ_UINT64_BE (data + 16);
+  header->total_size = GST_READ_UINT64_BE (data + 24);
+  header->offset = GST_READ_UINT64_BE (data + 32);
+  header->raw_size = GST_READ_UINT64_BE (data + 40);
+  header->sender = GST_READ_UINT32_BE (data + 48);
+  header->stripe = GST_READ_UINT16_BE (data + 52);
+
+  return TRUE;
+}
+
+guint64
+gst_zmq_wall_clock_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+/* stripe n of a striped stream uses the port n above the endpoint's, or
+ * the endpoint with "-n" appended when it has no port */
+gchar *
+gst_zmq_stripe_endpoint (const gchar * endpoint, guint stripe)
+{
+  const gchar *colon;
+  gchar *end;
+  guint64 port;
+
+  if (stripe == 0)
+    return g_strdup (endpoint);
+
+  colon = strrchr (endpoint, ':');
+  if (colon && g_ascii_isdigit (colon[1])) {
+    port = g_ascii_strtoull (colon + 1, &end, 10);
+    if (*end == '\0' && port + stripe <= G_MAXUINT16)
+      return g_strdup_printf ("%.*s:%" G_GUINT64_FORMAT,
+          (int) (colon - endpoint), endpoint, port + stripe);
+  }
+
+  return g_strdup_printf ("%s-%u", endpoint, stripe);
+}
+
+/* splits a comma separated list of endpoints, dropping blanks and
+ * duplicates, which would connect twice */
+gchar **
+gst_zmq_endpoints_parse (const gchar * list)
+{
+  gchar **endpoints = g_strsplit (list, ",", -1);
+  guint i, j, n = 0;
+
+  for (i = 0; endpoints[i]; i++) {
+    g_strstrip (endpoints[i]);
+    for (j = 0; j < n && strcmp (endpoints[j], endpoints[i]) != 0; j++);
+    if (endpoints[i][0] != '\0' && j == n)
+      endpoints[n++] = endpoints[i];
+    else
+      g_free (endpoints[i]);
+  }
+  endpoints[n] = NULL;
+
+  return endpoints;
+}
+
+/* a port of "*" is only chosen by libzmq when binding, so there is no
+ * port to count the stripes' ports up from */
+gboolean
+gst_zmq_endpoint_has_wildcard_port (const gchar * endpoint)
+{
+  const gchar *colon = strrchr (endpoint, ':');
+
+  return colon && strcmp (colon, ":*") == 0;
+}
+
+/* pgm:// and epgm:// endpoints need the multicast socket options */
+gboolean
+gst_zmq_endpoint_is_multicast (const gchar * endpoint)
+{
+  return g_str_has_prefix (endpoint, "pgm://")
+      || g_str_has_prefix (endpoint, "epgm://");
+}
+
+gboolean
+gst_zmq_endpoints_contain (gchar ** endpoints, const gchar * endpoint)
+{
+  for (; *endpoints; endpoints++) {
+    if (strcmp (*endpoints, endpoint) == 0)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* where the chunk of @size bytes carried by @stripe starts */
+gsize
+gst_zmq_stripe_offset (gsize size, guint stripe, guint stripes)
+{
+  return (guint64) size * stripe / stripes;
+}
+
+typedef struct
+{
+  guint64 start;
+  guint64 end;
+} GstZmqRange;
+
+void
+gst_zmq_reassembly_init (GstZmqReassembly * reassembly, GstZmqAllocFunc alloc,
+    GstZmqDecodeFunc decode, gpointer user_data, guint fragments,
+    gsize max_size, guint64 * dropped)
+{
+  memset (reassembly, 0, sizeof (GstZmqReassembly));
+  reassembly->alloc = alloc;
+  reassembly->decode = decode;
+  reassembly->user_data = user_data;
+  reassembly->fragments = fragments;
+  reassembly->max_size = max_size;
+  reassembly->dropped = dropped;
+}
+
+static void
+gst_zmq_reassembly_slot_free (GstZmqReassemblySlot * slot)
+{
+  if (slot->buffer) {
+    gst_buffer_unmap (slot->buffer, &slot->map);
+    gst_buffer_unref (slot->buffer);
+    slot->buffer = NULL;
+  }
+  slot->data = NULL;
+  slot->active = FALSE;
+}
+
+static void
+gst_zmq_reassembly_slot_drop (GstZmqReassembly * reassembly,
+    GstZmqReassemblySlot * slot)
+{
+  GST_DEBUG ("dropping incomplete payload %08x:%" G_GUINT64_FORMAT ", got %"
+      G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " bytes", slot->header.sender,
+      slot->header.seqnum, slot->received, slot->header.total_size);
+
+  gst_zmq_reassembly_slot_free (slot);
+  if (reassembly->dropped)
+    GST_ZMQ_STAT_INC (*reassembly->dropped);
+}
+
+void
+gst_zmq_reassembly_clear (GstZmqReassembly * reassembly)
+{
+  GstZmqReassemblySlot *slot;
+  guint i;
+
+  for (i = 0; i < GST_ZMQ_REASSEMBLY_SLOTS; i++) {
+    slot = &reassembly->slots[i];
+    if (slot->active)
+      gst_zmq_reassembly_slot_free (slot);
+    g_free (slot->staging);
+    slot->staging = NULL;
+    slot->staging_size = 0;
+    if (slot->ranges) {
+      g_array_free (slot->ranges, TRUE);
+      slot->ranges = NULL;
+    }
+  }
+}
+
+/* the number of payloads with fragments still outstanding */
+guint
+gst_zmq_reassembly_pending (const GstZmqReassembly * reassembly)
+{
+  guint i, pending = 0;
+
+  for (i = 0; i < GST_ZMQ_REASSEMBLY_SLOTS; i++) {
+    if (reassembly->slots[i].active)
+      pending++;
+  }
+
+  return pending;
+}
+
+static GstZmqReassemblySlot *
+gst_zmq_reassembly_find_slot (GstZmqReassembly * reassembly,
+    const GstZmqHeader * header)
+{
+  GstZmqReassemblySlot *slot, *free_slot = NULL, *oldest = NULL;
+  guint i;
+
+  /* seqnums are only comparable between messages of one sender, so the
+   * payload to give up on is the one started longest ago */
+  for (i = 0; i < GST_ZMQ_REASSEMBLY_SLOTS; i++) {
+    slot = &reassembly->slots[i];
+    if (!slot->active) {
+      if (!free_slot)
+        free_slot = slot;
+    } else if (slot->header.sender == header->sender
+        && slot->header.seqnum == header->seqnum) {
+      return slot;
+    } else if (!oldest || slot->started < oldest->started) {
+      oldest = slot;
+    }
+  }
+
+  if (!free_slot) {
+    gst_zmq_reassembly_slot_drop (reassembly, oldest);
+    free_slot = oldest;
+  }
+
+  if (header->flags & GST_ZMQ_HEADER_FLAG_COMPRESSED) {
+    /* only the decoded payload becomes a buffer; the staging memory is
+     * not sized like output buffers and is reused, so it comes from
+     * neither the pool nor the allocator */
+    if (free_slot->staging_size < header->total_size) {
+      g_free (free_slot->staging);
+      free_slot->staging = g_try_malloc (header->total_size);
+      free_slot->staging_size = free_slot->staging ? header->total_size : 0;
+      if (!free_slot->staging) {
+        GST_WARNING ("could not allocate %" G_GUINT64_FORMAT " bytes",
+            header->total_size);
+        return NULL;
+      }
+    }
+    free_slot->data = free_slot->staging;
+  } else {
+    free_slot->buffer = reassembly->alloc (header->total_size,
+        reassembly->user_data);
+    if (!free_slot->buffer)
+      return NULL;
+
+    if (!gst_buffer_map (free_slot->buffer, &free_slot->map, GST_MAP_WRITE)) {
+      GST_WARNING ("could not map a %" G_GUINT64_FORMAT " byte buffer",
+          header->total_size);
+      gst_buffer_unref (free_slot->buffer);
+      free_slot->buffer = NULL;
+      return NULL;
+    }
+    free_slot->data = free_slot->map.data;
+  }
+
+  if (!free_slot->ranges)
+    free_slot->ranges = g_array_new (FALSE, FALSE, sizeof (GstZmqRange));
+  g_array_set_size (free_slot->ranges, 0);
+
+  free_slot->header = *header;
+  free_slot->active = TRUE;
+  free_slot->started = reassembly->started++;
+  free_slot->received = 0;
+  free_slot->stripes = 0;
+
+  return free_slot;
+}
+
+/* records [start, end) as received, keeping the ranges sorted and merged;
+ * returns FALSE if any of it was received already */
+static gboolean
+gst_zmq_reassembly_slot_add_range (GstZmqReassemblySlot * slot,
+    guint64 start, guint64 end)
+{
+  GstZmqRange *ranges = (GstZmqRange *) slot->ranges->data;
+  GstZmqRange range = { start, end };
+  guint i, n = slot->ranges->len;
+
+  for (i = 0; i < n && ranges[i].end <= start; i++);
+  if (i < n && ranges[i].start < end)
+    return FALSE;
+
+  if (i > 0 && ranges[i - 1].end == start) {
+    ranges[i - 1].end = end;
+    if (i < n && ranges[i].start == end) {
+      ranges[i - 1].end = ranges[i].end;
+      g_array_remove_index (slot->ranges, i);
+    }
+  } else if (i < n && ranges[i].start == end) {
+    ranges[i].start = start;
+  } else {
+    g_array_insert_val (slot->ranges, i, range);
+  }
+
+  return TRUE;
+}
+
+/* copies one fragment into place; returns the whole payload once its last
+ * fragment arrived, decoded when it was compressed, with @header updated to
+ * the first fragment's header, and NULL until then */
+GstBuffer *
+gst_zmq_reassembly_push (GstZmqReassembly * reassembly, GstZmqHeader * header,
+    const guint8 * data, gsize size)
+{
+  GstZmqReassemblySlot *slot;
+  GstBuffer *buffer;
+  guint32 stripe = 0;
+  guint i;
+
+  if (header->total_size > reassembly->max_size
+      || header->offset > header->total_size
+      || size > header->total_size - header->offset
+      || (reassembly->fragments > 0
+          && header->stripe >= reassembly->fragments)) {
+    GST_WARNING ("ignoring fragment of %" G_GSIZE_FORMAT " bytes at %"
+        G_GUINT64_FORMAT " in a %" G_GUINT64_FORMAT " byte payload", size,
+        header->offset, header->total_size);
+    return NULL;
+  }
+
+  slot = gst_zmq_reassembly_find_slot (reassembly, header);
+  if (!slot)
+    return NULL;
+
+  /* a repeated fragment must not count twice towards completing the
+   * payload; striped fragments can be empty, so they are told apart by
+   * their stripe */
+  if (reassembly->fragments > 0)
+    stripe = 1 << header->stripe;
+
+  if (header->total_size != slot->header.total_size
+      || header->flags != slot->header.flags
+      || (slot->stripes & stripe)
+      || (size > 0 && !gst_zmq_reassembly_slot_add_range (slot,
+              header->offset, header->offset + size))) {
+    GST_DEBUG ("ignoring repeated or inconsistent fragment of %"
+        G_GSIZE_FORMAT " bytes at %" G_GUINT64_FORMAT " of payload %08x:%"
+        G_GUINT64_FORMAT, size, header->offset, header->sender,
+        header->seqnum);
+    return NULL;
+  }
+
+  memcpy (slot->data + header->offset, data, size);
+  slot->received += size;
+  slot->stripes |= stripe;
+
+  if (slot->received < slot->header.total_size
+      || slot->stripes != (1u << reassembly->fragments) - 1)
+    return NULL;
+
+  *header = slot->header;
+  if (slot->buffer) {
+    gst_buffer_unmap (slot->buffer, &slot->map);
+    buffer = slot->buffer;
+    slot->buffer = NULL;
+  } else {
+    buffer = reassembly->decode (header, slot->data, header->total_size,
+        reassembly->user_data);
+  }
+  slot->data = NULL;
+  slot->active = FALSE;
+
+  /* fragments are sent in payload order, and a striped payload is only
+   * complete after all older ones had their chance on every stripe, so
+   * anything older from the same sender is not going to be completed any
+   * more */
+  for (i = 0; i < GST_ZMQ_REASSEMBLY_SLOTS; i++) {
+    slot = &reassembly->slots[i];
+    if (slot->active && slot->header.sender == header->sender
+        && slot->header.seqnum < header->seqnum)
+      gst_zmq_reassembly_slot_drop (reassembly, slot);
+  }
+
+  return buffer;
+}
@@ -0,0 +1,164 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_ZMQ_FRAMING_H__
+#define __GST_ZMQ_FRAMING_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Optional header a zmqsink can put in front of each message payload.
+ * zmqsrc recognises it by its magic and strips it again. All fields are
+ * big endian:
+ *
+ *   0  magic        "GZMQ"
+ *   4  version      GST_ZMQ_HEADER_VERSION
+ *   5  flags        GstZmqHeaderFlags
+ *   6  header size  offset of the payload from the start of the message
+ *   8  seqnum       per-sink message counter
+ *  16  send time    sender wall clock in ns since the epoch, if STAMPED
+ *  24  total size   size of the whole payload
+ *  32  offset       where this message's data goes in the payload, if
+ *                   FRAGMENT
+ *  40  raw size     size of the payload after decompression, if LZ4 or
+ *                   ZSTD
+ *  48  sender       random id a zmqsink picks each time it starts
+ *  52  stripe       socket the message went out on, if FRAGMENT
+ *  54  reserved
+ *
+ * A FRAGMENT message carries only part of a payload; all fragments of a
+ * payload share its sender and seqnum and are put back together by a
+ * GstZmqReassembly. A compressed payload is compressed as a whole before
+ * it is split into fragments.
+ *
+ * The version goes up with every change to the layout, so that peers
+ * built from different versions pass each other's messages through as
+ * payload instead of misreading them.
+ */
+#define GST_ZMQ_HEADER_MAGIC 0x475a4d51
+#define GST_ZMQ_HEADER_VERSION 2
+#define GST_ZMQ_HEADER_SIZE 56
+
+typedef enum {
+  GST_ZMQ_HEADER_FLAG_STAMPED   = (1 << 0),
+  GST_ZMQ_HEADER_FLAG_FRAGMENT  = (1 << 1),
+  GST_ZMQ_HEADER_FLAG_LZ4       = (1 << 2),
+  GST_ZMQ_HEADER_FLAG_ZSTD      = (1 << 3)
+} GstZmqHeaderFlags;
+
+#define GST_ZMQ_HEADER_FLAG_COMPRESSED \
+  (GST_ZMQ_HEADER_FLAG_LZ4 | GST_ZMQ_HEADER_FLAG_ZSTD)
+
+#define GST_ZMQ_HEADER_FLAGS_KNOWN \
+  (GST_ZMQ_HEADER_FLAG_STAMPED | GST_ZMQ_HEADER_FLAG_FRAGMENT | \
+      GST_ZMQ_HEADER_FLAG_COMPRESSED)
+
+typedef struct _GstZmqHeader GstZmqHeader;
+
+struct _GstZmqHeader {
+  guint8 flags;
+  guint16 header_size;
+  guint64 seqnum;
+  guint64 send_time;
+  guint64 total_size;
+  guint64 offset;
+  guint64 raw_size;
+  guint32 sender;
+  guint16 stripe;
+};
+
+/* payloads in flight at once, the least recently started incomplete one is
+ * dropped to make room */
+#define GST_ZMQ_REASSEMBLY_SLOTS 4
+
+typedef GstBuffer *(*GstZmqAllocFunc) (gsize size, gpointer user_data);
+typedef GstBuffer *(*GstZmqDecodeFunc) (const GstZmqHeader * header,
+    const guint8 * data, gsize size, gpointer user_data);
+
+typedef struct _GstZmqReassemblySlot GstZmqReassemblySlot;
+typedef struct _GstZmqReassembly GstZmqReassembly;
+
+struct _GstZmqReassemblySlot {
+  GstZmqHeader header;
+  gboolean active;
+  guint8 *data;                 // where the payload is put together
+
+  // uncompressed payloads are put together in the output buffer itself
+  GstBuffer *buffer;
+  GstMapInfo map;
+
+  // compressed ones in memory kept for the next payload, to be decoded
+  // into the output buffer once complete
+  guint8 *staging;
+  gsize staging_size;
+
+  guint64 started;              // when this payload's first fragment came
+  guint64 received;
+  GArray *ranges;               // received byte ranges, sorted and merged
+  guint32 stripes;              // stripes received, one bit each
+};
+
+struct _GstZmqReassembly {
+  GstZmqReassemblySlot slots[GST_ZMQ_REASSEMBLY_SLOTS];
+
+  GstZmqAllocFunc alloc;
+  GstZmqDecodeFunc decode;
+  gpointer user_data;
+
+  // fragments making up a payload when striped, 0 when only the size tells
+  guint fragments;
+
+  // payloads claiming more than this are refused, the sizes come from the
+  // network; the owner may change it between pushes
+  gsize max_size;
+
+  guint64 started;
+
+  // payloads given up on
+  guint64 *dropped;
+};
+
+void gst_zmq_header_write (const GstZmqHeader * header, guint8 * data);
+gboolean gst_zmq_header_read (GstZmqHeader * header, const guint8 * data,
+    gsize size);
+
+guint64 gst_zmq_wall_clock_now (void);
+
+gchar *gst_zmq_stripe_endpoint (const gchar * endpoint, guint stripe);
+gsize gst_zmq_stripe_offset (gsize size, guint stripe, guint stripes);
+
+gchar **gst_zmq_endpoints_parse (const gchar * list);
+gboolean gst_zmq_endpoint_has_wildcard_port (const gchar * endpoint);
+gboolean gst_zmq_endpoint_is_multicast (const gchar * endpoint);
+gboolean gst_zmq_endpoints_contain (gchar ** endpoints,
+    const gchar * endpoint);
+
+void gst_zmq_reassembly_init (GstZmqReassembly * reassembly,
+    GstZmqAllocFunc alloc, GstZmqDecodeFunc decode, gpointer user_data,
+    guint fragments, gsize max_size, guint64 * dropped);
+void gst_zmq_reassembly_clear (GstZmqReassembly * reassembly);
+guint gst_zmq_reassembly_pending (const GstZmqReassembly * reassembly);
+GstBuffer *gst_zmq_reassembly_push (GstZmqReassembly * reassembly,
+    GstZmqHeader * header, const guint8 * data, gsize size);
+
+G_END_DECLS
+
+#endif /* __GST_ZMQ_FRAMING_H__ */
@@ -0,0 +1,98 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstzmqmeta.h"
+
+GType
+gst_zmq_meta_api_get_type (void)
+{
+  static gsize type = 0;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstZmqMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return (GType) type;
+}
+
+static gboolean
+gst_zmq_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+  GstZmqMeta *zmeta = (GstZmqMeta *) meta;
+
+  zmeta->seqnum = 0;
+  zmeta->send_time = 0;
+  zmeta->receive_time = 0;
+  zmeta->latency = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_zmq_meta_transform (GstBuffer * dest, GstMeta * meta, GstBuffer * buffer,
+    GQuark type, gpointer data)
+{
+  GstZmqMeta *zmeta = (GstZmqMeta *) meta;
+
+  /* timing is a property of the whole message, so it survives any copy */
+  gst_buffer_add_zmq_meta (dest, zmeta->seqnum, zmeta->send_time,
+      zmeta->receive_time, zmeta->latency);
+
+  return TRUE;
+}
+
+const GstMetaInfo *
+gst_zmq_meta_get_info (void)
+{
+  static const GstMetaInfo *meta_info = NULL;
+
+  if (g_once_init_enter (&meta_info)) {
+    const GstMetaInfo *mi = gst_meta_register (GST_ZMQ_META_API_TYPE,
+        "GstZmqMeta",
+        sizeof (GstZmqMeta),
+        gst_zmq_meta_init,
+        (GstMetaFreeFunction) NULL,
+        gst_zmq_meta_transform);
+    g_once_init_leave (&meta_info, mi);
+  }
+  return meta_info;
+}
+
+GstZmqMeta *
+gst_buffer_add_zmq_meta (GstBuffer * buffer, guint64 seqnum,
+    guint64 send_time, guint64 receive_time, gint64 latency)
+{
+  GstZmqMeta *zmeta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+
+  zmeta = (GstZmqMeta *) gst_buffer_add_meta (buffer, GST_ZMQ_META_INFO, NULL);
+
+  zmeta->seqnum = seqnum;
+  zmeta->send_time = send_time;
+  zmeta->receive_time = receive_time;
+  zmeta->latency = latency;
+
+  return zmeta;
+}
@@ -0,0 +1,63 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_ZMQ_META_H__
+#define __GST_ZMQ_META_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_ZMQ_META_API_TYPE (gst_zmq_meta_api_get_type())
+#define GST_ZMQ_META_INFO (gst_zmq_meta_get_info())
+
+#define gst_buffer_get_zmq_meta(b) \
+  ((GstZmqMeta*)gst_buffer_get_meta((b),GST_ZMQ_META_API_TYPE))
+
+typedef struct _GstZmqMeta GstZmqMeta;
+
+/**
+ * GstZmqMeta:
+ * @meta: parent #GstMeta
+ * @seqnum: sequence number the sending zmqsink gave the message
+ * @send_time: sender wall clock in ns since the epoch when it was sent
+ * @receive_time: receiver wall clock in ns since the epoch when it arrived
+ * @latency: one-way transport latency in ns, corrected by the clock offset
+ *
+ * Attached by zmqsrc to buffers that arrived with a sender timestamp.
+ */
+struct _GstZmqMeta {
+  GstMeta meta;
+
+  guint64 seqnum;
+  guint64 send_time;
+  guint64 receive_time;
+  gint64 latency;
+};
+
+GType gst_zmq_meta_api_get_type (void);
+const GstMetaInfo *gst_zmq_meta_get_info (void);
+
+GstZmqMeta *gst_buffer_add_zmq_meta (GstBuffer * buffer, guint64 seqnum,
+    guint64 send_time, guint64 receive_time, gint64 latency);
+
+G_END_DECLS
+
+#endif /* __GST_ZMQ_META_H__ */
@@ -0,0 +1,336 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>             // for memcpy
+
+#include <zmq.h>
+
+#include "gstzmqframing.h"
+#include "gstzmqmonitor.h"
+
+GST_DEBUG_CATEGORY_EXTERN (zmq_debug);
+#define GST_CAT_DEFAULT zmq_debug
+
+/* how often the monitor thread checks whether it should stop */
+#define MONITOR_POLL_MS 100
+
+GstZmqMonitor *
+gst_zmq_monitor_new (GstElement * element, void *context, GstZmqStats * stats)
+{
+  GstZmqMonitor *monitor;
+
+  monitor = g_new0 (GstZmqMonitor, 1);
+  monitor->element = element;
+  monitor->context = context;
+  monitor->stats = stats;
+  monitor->disconnected = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, NULL);
+
+  return monitor;
+}
+
+gboolean
+gst_zmq_monitor_add_socket (GstZmqMonitor * monitor, void *socket)
+{
+#if ZMQ_VERSION_MAJOR >= 4
+  gchar *endpoint;
+  void *pipe;
+  int linger = 0;
+  int rc;
+
+  g_return_val_if_fail (monitor->thread == NULL, FALSE);
+  g_return_val_if_fail (monitor->n_sockets < GST_ZMQ_MONITOR_MAX_SOCKETS,
+      FALSE);
+
+  endpoint = g_strdup_printf ("inproc://gstzmq-monitor-%p-%u", monitor,
+      monitor->n_sockets);
+
+  rc = zmq_socket_monitor (socket, endpoint, ZMQ_EVENT_ALL);
+  if (rc) {
+    GST_ELEMENT_WARNING (monitor->element, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_socket_monitor() failed with error code %d [%s], not "
+            "monitoring", errno, zmq_strerror (errno)), NULL);
+    g_free (endpoint);
+    return FALSE;
+  }
+
+  pipe = zmq_socket (monitor->context, ZMQ_PAIR);
+  if (!pipe) {
+    GST_ELEMENT_WARNING (monitor->element, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_socket() for monitor failed with error code %d [%s], not "
+            "monitoring", errno, zmq_strerror (errno)), NULL);
+    zmq_socket_monitor (socket, NULL, 0);
+    g_free (endpoint);
+    return FALSE;
+  }
+
+  rc = zmq_setsockopt (pipe, ZMQ_LINGER, &linger, sizeof (linger));
+  if (rc == 0)
+    rc = zmq_connect (pipe, endpoint);
+  g_free (endpoint);
+  if (rc) {
+    GST_ELEMENT_WARNING (monitor->element, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_connect() to monitor failed with error code %d [%s], not "
+            "monitoring", errno, zmq_strerror (errno)), NULL);
+    zmq_socket_monitor (socket, NULL, 0);
+    zmq_close (pipe);
+    return FALSE;
+  }
+
+  monitor->sockets[monitor->n_sockets] = socket;
+  monitor->pipes[monitor->n_sockets] = pipe;
+  monitor->n_sockets++;
+
+  return TRUE;
+#else
+  GST_ELEMENT_WARNING (monitor->element, RESOURCE, SETTINGS,
+      ("socket monitoring needs ZeroMQ 4 or newer"), NULL);
+  return FALSE;
+#endif
+}
+
+#if ZMQ_VERSION_MAJOR >= 4
+static const gchar *
+gst_zmq_monitor_event_name (guint16 event)
+{
+  switch (event) {
+    case ZMQ_EVENT_CONNECTED:
+      return "zmq-connected";
+    case ZMQ_EVENT_CONNECT_DELAYED:
+      return NULL;
+    case ZMQ_EVENT_CONNECT_RETRIED:
+      return "zmq-connect-retried";
+    case ZMQ_EVENT_LISTENING:
+      return "zmq-listening";
+    case ZMQ_EVENT_BIND_FAILED:
+      return "zmq-bind-failed";
+    case ZMQ_EVENT_ACCEPTED:
+      return "zmq-accepted";
+    case ZMQ_EVENT_ACCEPT_FAILED:
+      return "zmq-accept-failed";
+    case ZMQ_EVENT_CLOSED:
+      return "zmq-closed";
+    case ZMQ_EVENT_CLOSE_FAILED:
+      return "zmq-close-failed";
+    case ZMQ_EVENT_DISCONNECTED:
+      return "zmq-disconnected";
+#ifdef ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+    case ZMQ_EVENT_HANDSHAKE_SUCCEEDED:
+      return "zmq-handshake-succeeded";
+#endif
+#ifdef ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL
+    case ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL:
+    case ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL:
+    case ZMQ_EVENT_HANDSHAKE_FAILED_AUTH:
+      return "zmq-handshake-failed";
+#endif
+    default:
+      return NULL;
+  }
+}
+
+/* a peer is told apart by the socket and the endpoint in its events; peers
+ * accepted on one bound endpoint all share that endpoint, so there a new
+ * peer taking the place of one that left counts as a reconnect */
+static void
+gst_zmq_monitor_count_connection (GstZmqMonitor * monitor, guint index,
+    guint16 event, const gchar * address)
+{
+  gchar *key = g_strdup_printf ("%u %s", index, GST_STR_NULL (address));
+  guint pending;
+
+  pending = GPOINTER_TO_UINT (g_hash_table_lookup (monitor->disconnected,
+          key));
+
+  if (event == ZMQ_EVENT_DISCONNECTED) {
+    GST_ZMQ_STAT_INC (monitor->stats->disconnects);
+    g_hash_table_insert (monitor->disconnected, key,
+        GUINT_TO_POINTER (pending + 1));
+    return;
+  }
+
+  if (pending == 0) {
+    g_free (key);
+    return;
+  }
+
+  GST_ZMQ_STAT_INC (monitor->stats->reconnects);
+  if (pending > 1) {
+    g_hash_table_insert (monitor->disconnected, key,
+        GUINT_TO_POINTER (pending - 1));
+  } else {
+    g_hash_table_remove (monitor->disconnected, key);
+    g_free (key);
+  }
+}
+
+static void
+gst_zmq_monitor_handle_event (GstZmqMonitor * monitor, guint index)
+{
+  void *pipe = monitor->pipes[index];
+  zmq_msg_t msg;
+  const guint8 *data;
+  const gchar *name;
+  gchar *address = NULL;
+  guint16 event;
+  guint32 value;
+  guint64 timestamp;
+
+  timestamp = gst_zmq_wall_clock_now ();
+
+  /* first frame: 16 bit event and 32 bit value in host order, second
+   * frame: the endpoint address */
+  zmq_msg_init (&msg);
+  if (zmq_msg_recv (&msg, pipe, 0) < 0 || zmq_msg_size (&msg) < 6) {
+    zmq_msg_close (&msg);
+    return;
+  }
+  data = zmq_msg_data (&msg);
+  memcpy (&event, data, sizeof (event));
+  memcpy (&value, data + 2, sizeof (value));
+
+  while (zmq_msg_more (&msg)) {
+    zmq_msg_close (&msg);
+    zmq_msg_init (&msg);
+    if (zmq_msg_recv (&msg, pipe, 0) < 0)
+      break;
+    g_free (address);
+    address = g_strndup (zmq_msg_data (&msg), zmq_msg_size (&msg));
+  }
+  zmq_msg_close (&msg);
+
+  switch (event) {
+    case ZMQ_EVENT_DISCONNECTED:
+    case ZMQ_EVENT_CONNECTED:
+    case ZMQ_EVENT_ACCEPTED:
+      gst_zmq_monitor_count_connection (monitor, index, event, address);
+      break;
+    default:
+      break;
+  }
+
+  name = gst_zmq_monitor_event_name (event);
+
+  GST_DEBUG_OBJECT (monitor->element, "socket event 0x%04x (%s) value %u "
+      "on %s", event, GST_STR_NULL (name), value, GST_STR_NULL (address));
+
+  if (name) {
+    gst_element_post_message (monitor->element,
+        gst_message_new_element (GST_OBJECT (monitor->element),
+            gst_structure_new (name,
+                "endpoint", G_TYPE_STRING, address,
+                "value", G_TYPE_UINT, value,
+                "timestamp", G_TYPE_UINT64, timestamp, NULL)));
+  }
+
+  g_free (address);
+}
+
+static gpointer
+gst_zmq_monitor_thread (gpointer data)
+{
+  GstZmqMonitor *monitor = data;
+  zmq_pollitem_t items[GST_ZMQ_MONITOR_MAX_SOCKETS];
+  guint i;
+  int rc;
+
+  for (i = 0; i < monitor->n_sockets; i++) {
+    items[i].socket = monitor->pipes[i];
+    items[i].fd = 0;
+    items[i].events = ZMQ_POLLIN;
+    items[i].revents = 0;
+  }
+
+  while (g_atomic_int_get (&monitor->running)) {
+    rc = zmq_poll (items, monitor->n_sockets, MONITOR_POLL_MS);
+    if (rc < 0) {
+      if (EINTR == errno)
+        continue;
+      GST_WARNING_OBJECT (monitor->element, "zmq_poll() failed [%s]",
+          zmq_strerror (errno));
+      break;
+    }
+
+    for (i = 0; i < monitor->n_sockets; i++) {
+      if (items[i].revents & ZMQ_POLLIN)
+        gst_zmq_monitor_handle_event (monitor, i);
+    }
+  }
+
+  for (i = 0; i < monitor->n_sockets; i++)
+    zmq_close (monitor->pipes[i]);
+
+  return NULL;
+}
+#endif
+
+gboolean
+gst_zmq_monitor_start (GstZmqMonitor * monitor)
+{
+#if ZMQ_VERSION_MAJOR >= 4
+  GError *err = NULL;
+
+  if (monitor->n_sockets == 0)
+    return TRUE;
+
+  g_atomic_int_set (&monitor->running, TRUE);
+  monitor->thread = g_thread_try_new ("zmqmonitor", gst_zmq_monitor_thread,
+      monitor, &err);
+  if (!monitor->thread) {
+    GST_ELEMENT_WARNING (monitor->element, RESOURCE, FAILED,
+        ("could not start monitor thread: %s, not monitoring",
+            err->message), NULL);
+    g_error_free (err);
+    return FALSE;
+  }
+#endif
+
+  return TRUE;
+}
+
+/* must be called before the monitored sockets are closed */
+void
+gst_zmq_monitor_free (GstZmqMonitor * monitor)
+{
+  if (!monitor)
+    return;
+
+#if ZMQ_VERSION_MAJOR >= 4
+  guint i;
+
+  if (monitor->thread) {
+    g_atomic_int_set (&monitor->running, FALSE);
+    g_thread_join (monitor->thread);
+  } else {
+    for (i = 0; i < monitor->n_sockets; i++)
+      zmq_close (monitor->pipes[i]);
+  }
+
+  for (i = 0; i < monitor->n_sockets; i++)
+    zmq_socket_monitor (monitor->sockets[i], NULL, 0);
+#endif
+
+  g_hash_table_destroy (monitor->disconnected);
+  g_free (monitor);
+}
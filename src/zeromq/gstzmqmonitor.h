@@ -0,0 +1,63 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_ZMQ_MONITOR_H__
+#define __GST_ZMQ_MONITOR_H__
+
+#include <gst/gst.h>
+
+#include "gstzmqstats.h"
+
+G_BEGIN_DECLS
+
+#define GST_ZMQ_MONITOR_MAX_SOCKETS 16
+
+typedef struct _GstZmqMonitor GstZmqMonitor;
+
+/* Watches the connection lifecycle of an element's sockets from a thread of
+ * its own via zmq_socket_monitor(), and posts an element message for each
+ * event on the element's bus. Monitoring is best effort: failing to set it
+ * up posts a warning and the element carries on without it. */
+struct _GstZmqMonitor {
+  GstElement *element;
+  GstZmqStats *stats;
+  void *context;
+
+  void *sockets[GST_ZMQ_MONITOR_MAX_SOCKETS];
+  void *pipes[GST_ZMQ_MONITOR_MAX_SOCKETS];
+  guint n_sockets;
+
+  GThread *thread;
+  volatile gint running;
+
+  // disconnects not yet followed by a reconnect, per socket and endpoint;
+  // only touched by the monitor thread
+  GHashTable *disconnected;
+};
+
+GstZmqMonitor *gst_zmq_monitor_new (GstElement * element, void *context,
+    GstZmqStats * stats);
+gboolean gst_zmq_monitor_add_socket (GstZmqMonitor * monitor, void *socket);
+gboolean gst_zmq_monitor_start (GstZmqMonitor * monitor);
+void gst_zmq_monitor_free (GstZmqMonitor * monitor);
+
+G_END_DECLS
+
+#endif /* __GST_ZMQ_MONITOR_H__ */
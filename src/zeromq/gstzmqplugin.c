@@ -24,6 +24,7 @@
 
 #include "gstzmqsrc.h"
 #include "gstzmqsink.h"
+#include "gstzmqtracer.h"
 
 GST_DEBUG_CATEGORY (zmq_debug);
 
@@ -37,6 +38,9 @@ plugin_init (GstPlugin * plugin)
           GST_TYPE_ZMQ_SINK))
     return FALSE;
 
+  if (!gst_zmq_tracer_register (plugin))
+    return FALSE;
+
   GST_DEBUG_CATEGORY_INIT (zmq_debug, "zmq", 0, "ZeroMQ calls");
 
   return TRUE;
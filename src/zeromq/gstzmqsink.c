@@ -42,6 +42,7 @@
 #endif
 
 #include "gstzmq.h"
+#include "gstzmqframing.h"
 #include "gstzmqsink.h"
 
 GST_DEBUG_CATEGORY_STATIC (zmqsink_debug);
@@ -56,7 +57,24 @@ enum
 {
   PROP_0,
   PROP_ENDPOINT,
-  PROP_BIND
+  PROP_BIND,
+  PROP_SOCKET_TYPE,
+  PROP_GROUP,
+  PROP_MULTICAST_RATE,
+  PROP_MULTICAST_HOPS,
+  PROP_STAMP,
+  PROP_STRIPES,
+  PROP_COMPRESSION,
+  PROP_COMPRESSION_LEVEL,
+  PROP_COMPRESSION_BUDGET,
+  PROP_MONITOR,
+  PROP_RECONNECT_IVL,
+  PROP_RECONNECT_IVL_MAX,
+  PROP_HEARTBEAT_IVL,
+  PROP_HEARTBEAT_TIMEOUT,
+  PROP_HEARTBEAT_TTL,
+  PROP_STATS,
+  PROP_STATS_INTERVAL
 };
 
 static void gst_zmq_sink_finalize (GObject * gobject);
@@ -71,9 +89,33 @@ static gboolean gst_zmq_sink_stop (GstBaseSink * sink);
 static GstFlowReturn gst_zmq_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
 
+static void gst_zmq_sink_apply_endpoints (GstZmqSink * sink);
+static void gst_zmq_sink_request_reconfigure (GstZmqSink * sink);
+
 #define gst_zmq_sink_parent_class parent_class
 G_DEFINE_TYPE (GstZmqSink, gst_zmq_sink, GST_TYPE_BASE_SINK);
 
+#define GST_TYPE_ZMQ_SINK_SOCKET_TYPE (gst_zmq_sink_socket_type_get_type ())
+static GType
+gst_zmq_sink_socket_type_get_type (void)
+{
+  static GType socket_type = 0;
+  static const GEnumValue socket_types[] = {
+    {GST_ZMQ_SINK_SOCKET_TYPE_PUB, "PUB socket", "pub"},
+#ifdef HAVE_ZMQ_RADIO_DISH
+    {GST_ZMQ_SINK_SOCKET_TYPE_RADIO, "RADIO socket, for udp:// endpoints",
+        "radio"},
+#endif
+    {0, NULL, NULL}
+  };
+
+  if (!socket_type) {
+    socket_type = g_enum_register_static ("GstZmqSinkSocketType",
+        socket_types);
+  }
+  return socket_type;
+}
+
 static void
 gst_zmq_sink_class_init (GstZmqSinkClass * klass)
 {
@@ -93,21 +135,128 @@ gst_zmq_sink_class_init (GstZmqSinkClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_ENDPOINT,
       g_param_spec_string ("endpoint", "Endpoint",
-          "ZeroMQ endpoint through which to send buffers",
-          ZMQ_DEFAULT_ENDPOINT_SERVER,
-          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          "Comma separated ZeroMQ endpoints through which to send buffers; "
+          "changes apply with the next buffer", ZMQ_DEFAULT_ENDPOINT_SERVER,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_BIND,
       g_param_spec_boolean ("bind", "Bind",
-          "If true, bind to the endpoint (be the \"server\")",
-          ZMQ_DEFAULT_BIND_SINK, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          "If true, bind to the endpoints (be the \"server\")",
+          ZMQ_DEFAULT_BIND_SINK, G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SOCKET_TYPE,
+      g_param_spec_enum ("socket-type", "Socket type",
+          "Type of ZeroMQ socket to send on", GST_TYPE_ZMQ_SINK_SOCKET_TYPE,
+          GST_ZMQ_SINK_SOCKET_TYPE_PUB,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GROUP,
+      g_param_spec_string ("group", "Group",
+          "Group to send to on a RADIO socket", ZMQ_DEFAULT_GROUP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MULTICAST_RATE,
+      g_param_spec_int ("multicast-rate", "Multicast rate",
+          "Maximum send rate in kbit/s for pgm:// and epgm:// endpoints",
+          1, G_MAXINT, ZMQ_DEFAULT_MULTICAST_RATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MULTICAST_HOPS,
+      g_param_spec_int ("multicast-hops", "Multicast hops",
+          "Time to live of multicast packets for pgm:// and epgm:// endpoints",
+          1, 255, ZMQ_DEFAULT_MULTICAST_HOPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STAMP,
+      g_param_spec_boolean ("stamp", "Stamp",
+          "Prefix each message with a header carrying a sequence number and "
+          "the send time, so zmqsrc can measure transport latency",
+          ZMQ_DEFAULT_STAMP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STRIPES,
+      g_param_spec_uint ("stripes", "Stripes",
+          "Number of PUB sockets, each on its own ZeroMQ I/O thread and on "
+          "consecutive ports from the endpoint, to split every payload "
+          "across", 1, ZMQ_MAX_STRIPES, ZMQ_DEFAULT_STRIPES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_COMPRESSION,
+      g_param_spec_enum ("compression", "Compression",
+          "Compress each payload, unless it does not pay off",
+          GST_TYPE_ZMQ_COMPRESSION, GST_ZMQ_COMPRESSION_NONE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_COMPRESSION_LEVEL,
+      g_param_spec_int ("compression-level", "Compression level",
+          "zstd compression level, ignored by lz4 (0 = library default)",
+          0, 22, ZMQ_DEFAULT_COMPRESSION_LEVEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_COMPRESSION_BUDGET,
+      g_param_spec_uint ("compression-budget", "Compression budget",
+          "Back off from compressing while a payload takes longer than this "
+          "many us to compress (0 = unlimited)", 0, G_MAXUINT,
+          ZMQ_DEFAULT_COMPRESSION_BUDGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MONITOR,
+      g_param_spec_boolean ("monitor", "Monitor",
+          "Post element messages for connection events on the socket",
+          ZMQ_DEFAULT_MONITOR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_IVL,
+      g_param_spec_int ("reconnect-ivl", "Reconnect interval",
+          "Initial interval in ms between attempts to reconnect to a peer "
+          "(-1 = never reconnect)", -1, G_MAXINT, ZMQ_DEFAULT_RECONNECT_IVL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_IVL_MAX,
+      g_param_spec_int ("reconnect-ivl-max", "Maximum reconnect interval",
+          "Upper bound in ms for the exponentially growing reconnect "
+          "interval (0 = do not grow)", 0, G_MAXINT,
+          ZMQ_DEFAULT_RECONNECT_IVL_MAX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+#ifdef ZMQ_HEARTBEAT_IVL
+  g_object_class_install_property (gobject_class, PROP_HEARTBEAT_IVL,
+      g_param_spec_int ("heartbeat-ivl", "Heartbeat interval",
+          "Interval in ms between ZMTP heartbeats to peers (0 = disabled)",
+          0, G_MAXINT, ZMQ_DEFAULT_HEARTBEAT_IVL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HEARTBEAT_TIMEOUT,
+      g_param_spec_int ("heartbeat-timeout", "Heartbeat timeout",
+          "Time in ms without traffic after a heartbeat before a peer is "
+          "considered dead (0 = heartbeat-ivl)", 0, G_MAXINT,
+          ZMQ_DEFAULT_HEARTBEAT_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HEARTBEAT_TTL,
+      g_param_spec_int ("heartbeat-ttl", "Heartbeat TTL",
+          "Timeout in ms the peer should apply to our heartbeats "
+          "(0 = peer decides)", 0, 6553599, ZMQ_DEFAULT_HEARTBEAT_TTL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+#endif
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Counters and message size histogram for sent messages",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics interval",
+          "Post the stats as an element message every this many ms "
+          "(0 = disabled)", 0, G_MAXUINT, ZMQ_DEFAULT_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sinktemplate));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "ZeroMQ sink", "Sink/Network",
-      "Send data on ZeroMQ PUB socket",
+      "Send data on ZeroMQ PUB or RADIO socket",
       "Mark J. Howell <m0ppy at hypgnosys dot org>");
 
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_zmq_sink_start);
@@ -122,17 +271,49 @@ gst_zmq_sink_init (GstZmqSink * this)
 {
   this->endpoint = g_strdup (ZMQ_DEFAULT_ENDPOINT_SERVER);
   this->bind = ZMQ_DEFAULT_BIND_SINK;
-  this->context = zmq_ctx_new ();
+  this->socket_type = GST_ZMQ_SINK_SOCKET_TYPE_PUB;
+  this->group = g_strdup (ZMQ_DEFAULT_GROUP);
+  this->multicast_rate = ZMQ_DEFAULT_MULTICAST_RATE;
+  this->multicast_hops = ZMQ_DEFAULT_MULTICAST_HOPS;
+  this->stamp = ZMQ_DEFAULT_STAMP;
+  this->stripes = ZMQ_DEFAULT_STRIPES;
+  this->compression = GST_ZMQ_COMPRESSION_NONE;
+  this->compression_level = ZMQ_DEFAULT_COMPRESSION_LEVEL;
+  this->compression_budget = ZMQ_DEFAULT_COMPRESSION_BUDGET;
+  this->monitor = ZMQ_DEFAULT_MONITOR;
+  this->reconnect_ivl = ZMQ_DEFAULT_RECONNECT_IVL;
+  this->reconnect_ivl_max = ZMQ_DEFAULT_RECONNECT_IVL_MAX;
+  this->heartbeat_ivl = ZMQ_DEFAULT_HEARTBEAT_IVL;
+  this->heartbeat_timeout = ZMQ_DEFAULT_HEARTBEAT_TIMEOUT;
+  this->heartbeat_ttl = ZMQ_DEFAULT_HEARTBEAT_TTL;
+  this->stats.interval = ZMQ_DEFAULT_STATS_INTERVAL * GST_MSECOND;
 }
 
 static void
 gst_zmq_sink_finalize (GObject * gobject)
 {
   GstZmqSink *this = GST_ZMQ_SINK (gobject);
-  zmq_ctx_destroy (this->context);
+  g_free (this->endpoint);
+  g_free (this->group);
+  g_free (this->scratch);
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
 }
 
+/* applies a new endpoint or bind setting right away, an idle or paused
+ * sink may not render again for a long time; the sockets are only used
+ * with the preroll lock held, which basesink holds around render(), and
+ * start() and stop() take */
+static void
+gst_zmq_sink_request_reconfigure (GstZmqSink * sink)
+{
+  g_atomic_int_set (&sink->reconfigure, TRUE);
+
+  GST_BASE_SINK_PREROLL_LOCK (sink);
+  if (sink->n_sockets > 0 && g_atomic_int_get (&sink->reconfigure))
+    gst_zmq_sink_apply_endpoints (sink);
+  GST_BASE_SINK_PREROLL_UNLOCK (sink);
+}
+
 static void
 gst_zmq_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -147,13 +328,71 @@ gst_zmq_sink_set_property (GObject * object, guint prop_id,
         g_warning ("endpoint property cannot be NULL");
         break;
       }
-      if (sink->endpoint) {
-        g_free (sink->endpoint);
-      }
+      GST_OBJECT_LOCK (sink);
+      g_free (sink->endpoint);
       sink->endpoint = g_strdup (g_value_get_string (value));
+      GST_OBJECT_UNLOCK (sink);
+      gst_zmq_sink_request_reconfigure (sink);
       break;
     case PROP_BIND:
+      GST_OBJECT_LOCK (sink);
       sink->bind = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (sink);
+      gst_zmq_sink_request_reconfigure (sink);
+      break;
+    case PROP_SOCKET_TYPE:
+      sink->socket_type = g_value_get_enum (value);
+      break;
+    case PROP_GROUP:
+      if (!g_value_get_string (value)) {
+        g_warning ("group property cannot be NULL");
+        break;
+      }
+      g_free (sink->group);
+      sink->group = g_strdup (g_value_get_string (value));
+      break;
+    case PROP_MULTICAST_RATE:
+      sink->multicast_rate = g_value_get_int (value);
+      break;
+    case PROP_MULTICAST_HOPS:
+      sink->multicast_hops = g_value_get_int (value);
+      break;
+    case PROP_STAMP:
+      sink->stamp = g_value_get_boolean (value);
+      break;
+    case PROP_STRIPES:
+      sink->stripes = g_value_get_uint (value);
+      break;
+    case PROP_COMPRESSION:
+      sink->compression = g_value_get_enum (value);
+      break;
+    case PROP_COMPRESSION_LEVEL:
+      sink->compression_level = g_value_get_int (value);
+      break;
+    case PROP_COMPRESSION_BUDGET:
+      sink->compression_budget = g_value_get_uint (value);
+      break;
+    case PROP_MONITOR:
+      sink->monitor = g_value_get_boolean (value);
+      break;
+    case PROP_RECONNECT_IVL:
+      sink->reconnect_ivl = g_value_get_int (value);
+      break;
+    case PROP_RECONNECT_IVL_MAX:
+      sink->reconnect_ivl_max = g_value_get_int (value);
+      break;
+    case PROP_HEARTBEAT_IVL:
+      sink->heartbeat_ivl = g_value_get_int (value);
+      break;
+    case PROP_HEARTBEAT_TIMEOUT:
+      sink->heartbeat_timeout = g_value_get_int (value);
+      break;
+    case PROP_HEARTBEAT_TTL:
+      sink->heartbeat_ttl = g_value_get_int (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      __atomic_store_n (&sink->stats.interval,
+          g_value_get_uint (value) * GST_MSECOND, __ATOMIC_RELAXED);
       break;
 
     default:
@@ -172,17 +411,257 @@ gst_zmq_sink_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_ENDPOINT:
+      GST_OBJECT_LOCK (sink);
       g_value_set_string (value, sink->endpoint);
+      GST_OBJECT_UNLOCK (sink);
       break;
     case PROP_BIND:
       g_value_set_boolean (value, sink->bind);
       break;
+    case PROP_SOCKET_TYPE:
+      g_value_set_enum (value, sink->socket_type);
+      break;
+    case PROP_GROUP:
+      g_value_set_string (value, sink->group);
+      break;
+    case PROP_MULTICAST_RATE:
+      g_value_set_int (value, sink->multicast_rate);
+      break;
+    case PROP_MULTICAST_HOPS:
+      g_value_set_int (value, sink->multicast_hops);
+      break;
+    case PROP_STAMP:
+      g_value_set_boolean (value, sink->stamp);
+      break;
+    case PROP_STRIPES:
+      g_value_set_uint (value, sink->stripes);
+      break;
+    case PROP_COMPRESSION:
+      g_value_set_enum (value, sink->compression);
+      break;
+    case PROP_COMPRESSION_LEVEL:
+      g_value_set_int (value, sink->compression_level);
+      break;
+    case PROP_COMPRESSION_BUDGET:
+      g_value_set_uint (value, sink->compression_budget);
+      break;
+    case PROP_MONITOR:
+      g_value_set_boolean (value, sink->monitor);
+      break;
+    case PROP_RECONNECT_IVL:
+      g_value_set_int (value, sink->reconnect_ivl);
+      break;
+    case PROP_RECONNECT_IVL_MAX:
+      g_value_set_int (value, sink->reconnect_ivl_max);
+      break;
+    case PROP_HEARTBEAT_IVL:
+      g_value_set_int (value, sink->heartbeat_ivl);
+      break;
+    case PROP_HEARTBEAT_TIMEOUT:
+      g_value_set_int (value, sink->heartbeat_timeout);
+      break;
+    case PROP_HEARTBEAT_TTL:
+      g_value_set_int (value, sink->heartbeat_ttl);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_zmq_stats_get_structure (&sink->stats, "zmqsink-stats"));
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value,
+          GST_ZMQ_STAT_GET (sink->stats.interval) / GST_MSECOND);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* hands @msg over to ZeroMQ; PUB and RADIO sockets never refuse a
+ * message, one that does not fit below a peer's high water mark is
+ * dropped for that peer inside ZeroMQ, where it cannot be counted */
+static GstFlowReturn
+gst_zmq_sink_send_msg (GstZmqSink * sink, void *socket, zmq_msg_t * msg)
+{
+  gsize msg_size = zmq_msg_size (msg);
+  GstClockTime start, now;
+  int rc;
+
+#ifdef HAVE_ZMQ_RADIO_DISH
+  if (sink->socket_type == GST_ZMQ_SINK_SOCKET_TYPE_RADIO)
+    zmq_msg_set_group (msg, sink->group);
+#endif
+
+  start = gst_util_get_timestamp ();
+  rc = zmq_msg_send (msg, socket, 0);
+  now = gst_util_get_timestamp ();
+
+  sink->timing.send += now - start;
+  sink->timing.messages++;
+
+  if (rc >= 0 && (gsize) rc == msg_size) {
+    gst_zmq_stats_add_message (&sink->stats, msg_size, now - start);
+    gst_zmq_stats_maybe_post (&sink->stats, GST_ELEMENT (sink),
+        "zmqsink-stats", now);
+  } else {
+    GST_ZMQ_STAT_INC (sink->stats.errors);
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE,
+        ("zmq_msg_send() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    zmq_msg_close (msg);
+    return GST_FLOW_ERROR;
+  }
+
+  return GST_FLOW_OK;
+}
+
+/* sends one ZeroMQ message made of the optional header followed by @size
+ * bytes of @data */
+static GstFlowReturn
+gst_zmq_sink_send (GstZmqSink * sink, void *socket, GstZmqHeader * header,
+    const guint8 * data, gsize size)
+{
+  zmq_msg_t msg;
+  gsize header_size = header ? GST_ZMQ_HEADER_SIZE : 0;
+  GstClockTime start = 0;
+  int rc;
+
+  if (GST_ZMQ_TRACING ())
+    start = gst_util_get_timestamp ();
+
+  rc = zmq_msg_init_size (&msg, header_size + size);
+  if (rc) {
+    GST_ZMQ_STAT_INC (sink->stats.errors);
+    GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
+        ("zmq_msg_init_size() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    return GST_FLOW_ERROR;
+  }
+
+  memcpy ((guint8 *) zmq_msg_data (&msg) + header_size, data, size);
+
+  /* stamp as late as possible so the latency seen by zmqsrc is the time
+   * spent in ZeroMQ and on the wire */
+  if (header) {
+    if (header->flags & GST_ZMQ_HEADER_FLAG_STAMPED)
+      header->send_time = gst_zmq_wall_clock_now ();
+    gst_zmq_header_write (header, zmq_msg_data (&msg));
+  }
+
+  if (start)
+    sink->timing.copy += gst_util_get_timestamp () - start;
+
+  return gst_zmq_sink_send_msg (sink, socket, &msg);
+}
+
+typedef struct
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+} GstZmqSinkMapping;
+
+/* called by ZeroMQ, from one of its I/O threads, once the message is sent
+ * to every peer */
+static void
+gst_zmq_sink_free_mapping (void *data, void *hint)
+{
+  GstZmqSinkMapping *mapping = hint;
+
+  gst_buffer_unmap (mapping->buffer, &mapping->map);
+  gst_buffer_unref (mapping->buffer);
+  g_slice_free (GstZmqSinkMapping, mapping);
+}
+
+/* sends the memory of @buffer as one message without copying it, keeping
+ * the buffer alive until ZeroMQ is done with it */
+static GstFlowReturn
+gst_zmq_sink_send_buffer (GstZmqSink * sink, void *socket, GstBuffer * buffer)
+{
+  GstZmqSinkMapping *mapping = g_slice_new (GstZmqSinkMapping);
+  zmq_msg_t msg;
+  int rc;
+
+  if (!gst_buffer_map (buffer, &mapping->map, GST_MAP_READ)) {
+    g_slice_free (GstZmqSinkMapping, mapping);
+    GST_ZMQ_STAT_INC (sink->stats.errors);
+    GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
+        ("could not map a %" G_GSIZE_FORMAT " byte buffer",
+            gst_buffer_get_size (buffer)), NULL);
+    return GST_FLOW_ERROR;
+  }
+  mapping->buffer = gst_buffer_ref (buffer);
+
+  rc = zmq_msg_init_data (&msg, mapping->map.data, mapping->map.size,
+      gst_zmq_sink_free_mapping, mapping);
+  if (rc) {
+    gst_zmq_sink_free_mapping (NULL, mapping);
+    GST_ZMQ_STAT_INC (sink->stats.errors);
+    GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
+        ("zmq_msg_init_data() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    return GST_FLOW_ERROR;
+  }
+
+  return gst_zmq_sink_send_msg (sink, socket, &msg);
+}
+
+/* compresses @size bytes of @data into the scratch buffer and returns the
+ * compressed size, or 0 to send the payload as is */
+static gsize
+gst_zmq_sink_compress (GstZmqSink * sink, const guint8 * data, gsize size)
+{
+  GstClockTime start, elapsed;
+  gsize bound, compressed;
+  gboolean worth_it;
+
+  if (sink->compress_skip > 0) {
+    sink->compress_skip--;
+    GST_ZMQ_STAT_INC (sink->stats.compression_bypassed);
+    return 0;
+  }
+
+  bound = gst_zmq_compress_bound (sink->compression, size);
+  if (bound == 0)
+    return 0;
+
+  if (bound > sink->scratch_size) {
+    g_free (sink->scratch);
+    sink->scratch = g_malloc (bound);
+    sink->scratch_size = bound;
+  }
+
+  start = gst_util_get_timestamp ();
+  compressed = gst_zmq_compress (sink->compression, sink->compression_level,
+      data, size, sink->scratch, sink->scratch_size);
+  elapsed = gst_util_get_timestamp () - start;
+  sink->timing.compress = elapsed;
+
+  worth_it = compressed > 0
+      && compressed < size - size / ZMQ_COMPRESSION_MIN_GAIN;
+
+  /* back off exponentially while compression does not pay, and probe
+   * again once in a while, since content changes */
+  if (!worth_it || (sink->compression_budget > 0
+          && elapsed > sink->compression_budget * GST_USECOND)) {
+    sink->compress_backoff = CLAMP (sink->compress_backoff * 2, 1,
+        ZMQ_COMPRESSION_MAX_SKIP);
+    sink->compress_skip = sink->compress_backoff;
+    GST_LOG_OBJECT (sink, "compressed %" G_GSIZE_FORMAT " to %"
+        G_GSIZE_FORMAT " bytes in %" GST_TIME_FORMAT ", skipping next %u",
+        size, compressed, GST_TIME_ARGS (elapsed), sink->compress_skip);
+  } else {
+    sink->compress_backoff = 0;
+  }
+
+  if (!worth_it) {
+    GST_ZMQ_STAT_INC (sink->stats.compression_bypassed);
+    return 0;
+  }
+
+  GST_ZMQ_STAT_INC (sink->stats.compressed);
+  return compressed;
+}
+
 static GstFlowReturn
 gst_zmq_sink_render (GstBaseSink * basesink, GstBuffer * buffer)
 {
@@ -191,80 +670,456 @@ gst_zmq_sink_render (GstBaseSink * basesink, GstBuffer * buffer)
 
   GstZmqSink *sink;
   GstMapInfo map;
+  GstZmqHeader header;
+  gsize max_size = G_MAXSIZE, offset, size, compressed = 0;
+  const guint8 *data;
+  gboolean tracing = GST_ZMQ_TRACING ();
+  GstClockTime start = 0;
+  guint i;
 
   sink = GST_ZMQ_SINK (basesink);
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (g_atomic_int_get (&sink->reconfigure))
+    gst_zmq_sink_apply_endpoints (sink);
+
+  if (tracing) {
+    memset (&sink->timing, 0, sizeof (sink->timing));
+    start = gst_util_get_timestamp ();
+  }
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ZMQ_STAT_INC (sink->stats.errors);
+    GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
+        ("could not map a %" G_GSIZE_FORMAT " byte buffer",
+            gst_buffer_get_size (buffer)), NULL);
+    return GST_FLOW_ERROR;
+  }
+
+  if (tracing)
+    sink->timing.map = gst_util_get_timestamp () - start;
 
   GST_DEBUG_OBJECT (sink, "publishing %" G_GSIZE_FORMAT " bytes", map.size);
 
-  if (map.size > 0 && map.data != NULL) {
-    zmq_msg_t msg;
-    int rc = zmq_msg_init_size (&msg, map.size);
-    if (rc) {
-      GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
-          ("zmq_msg_init_size() failed with error code %d [%s]", errno,
-              zmq_strerror (errno)), NULL);
-      retval = GST_FLOW_ERROR;
-    } else {
-      memcpy (zmq_msg_data (&msg), map.data, map.size);
-
-      rc = zmq_msg_send (&msg, sink->socket, 0);
-      if (rc != map.size) {
-        GST_ELEMENT_ERROR (sink, RESOURCE, WRITE,
-            ("zmq_msg_send() failed with error code %d [%s]", errno,
-                zmq_strerror (errno)), NULL);
-        zmq_msg_close (&msg);
-        retval = GST_FLOW_ERROR;
+  /* a datagram must hold the group and the header besides the data */
+  if (sink->socket_type == GST_ZMQ_SINK_SOCKET_TYPE_RADIO)
+    max_size = ZMQ_RADIO_MAX_DATAGRAM - 1 - strlen (sink->group) -
+        GST_ZMQ_HEADER_SIZE;
+
+  data = map.data;
+  size = map.size;
+
+  header.flags = sink->stamp ? GST_ZMQ_HEADER_FLAG_STAMPED : 0;
+  header.seqnum = sink->seqnum;
+  header.send_time = 0;
+  header.offset = 0;
+  header.raw_size = map.size;
+  header.sender = sink->sender;
+  header.stripe = 0;
+
+  if (sink->compression != GST_ZMQ_COMPRESSION_NONE && size > 0)
+    compressed = gst_zmq_sink_compress (sink, data, size);
+
+  if (compressed > 0) {
+    header.flags |= gst_zmq_compression_flag (sink->compression);
+    data = sink->scratch;
+    size = compressed;
+  }
+
+  header.total_size = size;
+
+  /* an empty buffer sends nothing, so it must not leave a gap in the
+   * sequence numbers either */
+  if (size > 0 && data != NULL) {
+    sink->seqnum++;
+    if (sink->n_sockets > 1) {
+      /* every payload is split into one chunk per stripe, even tiny ones,
+       * so a payload can only be complete at zmqsrc once the previous one
+       * is, each stripe being in order */
+      header.flags |= GST_ZMQ_HEADER_FLAG_FRAGMENT;
+      for (i = 0; i < sink->n_sockets && retval == GST_FLOW_OK; i++) {
+        header.stripe = i;
+        header.offset = gst_zmq_stripe_offset (size, i, sink->n_sockets);
+        retval = gst_zmq_sink_send (sink, sink->sockets[i], &header,
+            data + header.offset, gst_zmq_stripe_offset (size, i + 1,
+                sink->n_sockets) - header.offset);
       }
+    } else if (size > max_size) {
+      header.flags |= GST_ZMQ_HEADER_FLAG_FRAGMENT;
+      for (offset = 0; offset < size && retval == GST_FLOW_OK;
+          offset += max_size) {
+        header.offset = offset;
+        retval = gst_zmq_sink_send (sink, sink->sockets[0], &header,
+            data + offset, MIN (max_size, size - offset));
+      }
+    } else if (header.flags == 0 && size >= ZMQ_ZERO_COPY_MIN_SIZE
+        && gst_buffer_n_memory (buffer) == 1) {
+      retval = gst_zmq_sink_send_buffer (sink, sink->sockets[0], buffer);
+    } else {
+      retval = gst_zmq_sink_send (sink, sink->sockets[0],
+          header.flags ? &header : NULL, data, size);
     }
   }
 
   gst_buffer_unmap (buffer, &map);
 
+  if (tracing)
+    gst_zmq_tracer_log_render (GST_ELEMENT (sink), &sink->timing, map.size);
+
   return retval;
 
 }
 
+static gboolean
+gst_zmq_sink_set_int_option (GstZmqSink * sink, void *socket, int option,
+    int value)
+{
+  int rc = zmq_setsockopt (socket, option, &value, sizeof (value));
+
+  if (rc) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, SETTINGS,
+        ("zmq_setsockopt() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* catch the endpoint and socket type combinations libzmq would only
+ * reject with an unhelpful errno; like gst_zmq_sink_attach(), an error when
+ * starting, but only a warning for a change while streaming */
+static gboolean
+gst_zmq_sink_check_transport (GstZmqSink * sink, const gchar * endpoint,
+    gboolean live)
+{
+  gchar *message = NULL;
+  gboolean ok;
+
+#ifdef HAVE_ZMQ_HAS
+  if (gst_zmq_endpoint_is_multicast (endpoint) && !zmq_has ("pgm"))
+    message = g_strdup_printf ("endpoint \"%s\" needs a libzmq built with "
+        "PGM support", endpoint);
+#endif
+
+  if (!message && sink->stripes > 1
+      && gst_zmq_endpoint_has_wildcard_port (endpoint))
+    message = g_strdup_printf ("endpoint \"%s\" cannot be striped: "
+        "stripe n uses the port n above the endpoint's, and a wildcard port "
+        "has no number to count from", endpoint);
+
+  if (!message && sink->socket_type == GST_ZMQ_SINK_SOCKET_TYPE_RADIO) {
+    if (!g_str_has_prefix (endpoint, "udp://"))
+      message = g_strdup_printf ("RADIO sockets need a udp:// endpoint, "
+          "not \"%s\"", endpoint);
+    else if (strlen (sink->group) == 0 || strlen (sink->group) > 15)
+      message = g_strdup_printf ("group \"%s\" must be 1 to 15 characters",
+          sink->group);
+    else if (sink->stripes > 1)
+      message = g_strdup ("RADIO sockets cannot be striped");
+  }
+
+  if (message && live)
+    GST_ELEMENT_WARNING (sink, RESOURCE, SETTINGS, ("%s", message), NULL);
+  else if (message)
+    GST_ELEMENT_ERROR (sink, RESOURCE, SETTINGS, ("%s", message), NULL);
+
+  ok = message == NULL;
+  g_free (message);
+
+  return ok;
+}
+
+static gboolean
+gst_zmq_sink_set_connection_options (GstZmqSink * sink, void *socket)
+{
+  if (!gst_zmq_sink_set_int_option (sink, socket, ZMQ_LINGER,
+          ZMQ_SINK_LINGER_MS)
+      || !gst_zmq_sink_set_int_option (sink, socket, ZMQ_RECONNECT_IVL,
+          sink->reconnect_ivl)
+      || !gst_zmq_sink_set_int_option (sink, socket, ZMQ_RECONNECT_IVL_MAX,
+          sink->reconnect_ivl_max))
+    return FALSE;
+
+#ifdef ZMQ_HEARTBEAT_IVL
+  if (!gst_zmq_sink_set_int_option (sink, socket, ZMQ_HEARTBEAT_IVL,
+          sink->heartbeat_ivl)
+      || !gst_zmq_sink_set_int_option (sink, socket, ZMQ_HEARTBEAT_TIMEOUT,
+          sink->heartbeat_timeout ? sink->heartbeat_timeout :
+          sink->heartbeat_ivl)
+      || !gst_zmq_sink_set_int_option (sink, socket, ZMQ_HEARTBEAT_TTL,
+          sink->heartbeat_ttl))
+    return FALSE;
+#endif
+
+  return TRUE;
+}
+
+/* binds or connects the socket of @stripe to @endpoint; failing is an
+ * error when starting, but only a warning for a change while streaming */
+static gboolean
+gst_zmq_sink_attach (GstZmqSink * sink, guint stripe, const gchar * endpoint,
+    gboolean bind, gboolean live)
+{
+  void *socket = sink->sockets[stripe];
+  gchar *address = gst_zmq_stripe_endpoint (endpoint, stripe);
+  gchar *message = NULL;
+  int rc = 0;
+
+  if (gst_zmq_endpoint_is_multicast (address)) {
+    rc = zmq_setsockopt (socket, ZMQ_RATE, &sink->multicast_rate,
+        sizeof (sink->multicast_rate));
+    if (rc == 0)
+      rc = zmq_setsockopt (socket, ZMQ_MULTICAST_HOPS, &sink->multicast_hops,
+          sizeof (sink->multicast_hops));
+    if (rc)
+      message = g_strdup_printf ("zmq_setsockopt() failed with error code "
+          "%d [%s]", errno, zmq_strerror (errno));
+  }
+
+  if (rc == 0) {
+    GST_DEBUG_OBJECT (sink, "%s endpoint %s", bind ? "binding to" :
+        "connecting to", address);
+    rc = bind ? zmq_bind (socket, address) : zmq_connect (socket, address);
+    if (rc)
+      message = g_strdup_printf ("%s to endpoint \"%s\" failed with error "
+          "code %d [%s]", bind ? "zmq_bind()" : "zmq_connect()", address,
+          errno, zmq_strerror (errno));
+  }
+
+  /* libzmq only unbinds a wildcard such as tcp://*:5556 by the address it
+   * resolved to, so remember that */
+  if (rc == 0) {
+    gchar resolved[256];
+    size_t size = sizeof (resolved);
+
+    if (bind && zmq_getsockopt (socket, ZMQ_LAST_ENDPOINT, resolved,
+            &size) == 0)
+      g_hash_table_insert (sink->attached,
+          g_strdup_printf ("%u %s", stripe, address), g_strdup (resolved));
+    else
+      g_hash_table_insert (sink->attached,
+          g_strdup_printf ("%u %s", stripe, address), g_strdup (address));
+  }
+
+  if (message && live)
+    GST_ELEMENT_WARNING (sink, RESOURCE, OPEN_READ_WRITE, ("%s", message),
+        NULL);
+  else if (message)
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE, ("%s", message),
+        NULL);
+
+  g_free (message);
+  g_free (address);
+
+  return rc == 0;
+}
+
+/* undoes gst_zmq_sink_attach(); returns FALSE if the endpoint is still
+ * attached */
+static gboolean
+gst_zmq_sink_detach (GstZmqSink * sink, guint stripe, const gchar * endpoint,
+    gboolean bind)
+{
+  void *socket = sink->sockets[stripe];
+  gchar *address = gst_zmq_stripe_endpoint (endpoint, stripe);
+  gchar *key = g_strdup_printf ("%u %s", stripe, address);
+  const gchar *target = g_hash_table_lookup (sink->attached, key);
+  int rc = 0;
+
+  if (target) {
+    GST_DEBUG_OBJECT (sink, "%s endpoint %s", bind ? "unbinding from" :
+        "disconnecting from", target);
+    rc = bind ? zmq_unbind (socket, target) : zmq_disconnect (socket, target);
+    if (rc)
+      GST_ELEMENT_WARNING (sink, RESOURCE, CLOSE,
+          ("%s from endpoint \"%s\" failed with error code %d [%s]",
+              bind ? "zmq_unbind()" : "zmq_disconnect()", target, errno,
+              zmq_strerror (errno)), NULL);
+    else
+      g_hash_table_remove (sink->attached, key);
+  }
+
+  g_free (key);
+  g_free (address);
+
+  return rc == 0;
+}
+
+/* brings the sockets up to date with the endpoint and bind properties,
+ * leaving the endpoints that stay alone, so their peers do not notice;
+ * an endpoint that cannot be added is reported and left out, one that
+ * cannot be removed is reported and kept for the next change */
+static void
+gst_zmq_sink_apply_endpoints (GstZmqSink * sink)
+{
+  GPtrArray *applied = g_ptr_array_new ();
+  gchar **endpoints;
+  gboolean bind, rebind, ok;
+  guint i, stripe;
+
+  g_atomic_int_set (&sink->reconfigure, FALSE);
+
+  GST_OBJECT_LOCK (sink);
+  endpoints = gst_zmq_endpoints_parse (sink->endpoint);
+  bind = sink->bind;
+  GST_OBJECT_UNLOCK (sink);
+
+  /* switching between binding and connecting redoes every endpoint */
+  rebind = bind != sink->bound;
+
+  for (i = 0; sink->endpoints[i]; i++) {
+    if (!rebind && gst_zmq_endpoints_contain (endpoints, sink->endpoints[i]))
+      continue;
+    GST_INFO_OBJECT (sink, "removing endpoint %s", sink->endpoints[i]);
+    ok = TRUE;
+    for (stripe = 0; stripe < sink->n_sockets; stripe++)
+      ok = gst_zmq_sink_detach (sink, stripe, sink->endpoints[i],
+          sink->bound) && ok;
+    /* after a rebind it would be detached the wrong way next time */
+    if (!ok && !rebind)
+      g_ptr_array_add (applied, g_strdup (sink->endpoints[i]));
+  }
+
+  for (i = 0; endpoints[i]; i++) {
+    ok = TRUE;
+    if (rebind || !gst_zmq_endpoints_contain (sink->endpoints, endpoints[i])) {
+      GST_INFO_OBJECT (sink, "adding endpoint %s", endpoints[i]);
+      ok = gst_zmq_sink_check_transport (sink, endpoints[i], TRUE);
+      for (stripe = 0; ok && stripe < sink->n_sockets; stripe++)
+        ok = gst_zmq_sink_attach (sink, stripe, endpoints[i], bind, TRUE);
+      /* a stream is striped over all of the sockets or none */
+      while (!ok && stripe-- > 1)
+        gst_zmq_sink_detach (sink, stripe - 1, endpoints[i], bind);
+    }
+    if (ok)
+      g_ptr_array_add (applied, g_strdup (endpoints[i]));
+  }
+  g_ptr_array_add (applied, NULL);
+
+  g_strfreev (endpoints);
+  g_strfreev (sink->endpoints);
+  sink->endpoints = (gchar **) g_ptr_array_free (applied, FALSE);
+  sink->bound = bind;
+}
+
+/* creates, configures and binds or connects the socket of one stripe */
+static gboolean
+gst_zmq_sink_open_socket (GstZmqSink * sink, guint stripe)
+{
+  gboolean retval = TRUE;
+  void *socket;
+  guint i;
+  int rc;
+
+#ifdef HAVE_ZMQ_RADIO_DISH
+  if (sink->socket_type == GST_ZMQ_SINK_SOCKET_TYPE_RADIO)
+    socket = zmq_socket (sink->context, ZMQ_RADIO);
+  else
+#endif
+    socket = zmq_socket (sink->context, ZMQ_PUB);
+  if (!socket) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_socket() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    return FALSE;
+  }
+  sink->sockets[sink->n_sockets++] = socket;
+
+  if (!gst_zmq_sink_set_connection_options (sink, socket)) {
+    retval = FALSE;
+  } else if (sink->stripes > 1) {
+    /* pin each stripe to an I/O thread of its own */
+    guint64 affinity = G_GUINT64_CONSTANT (1) << stripe;
+    rc = zmq_setsockopt (socket, ZMQ_AFFINITY, &affinity, sizeof (affinity));
+    if (rc) {
+      GST_ELEMENT_ERROR (sink, RESOURCE, SETTINGS,
+          ("zmq_setsockopt() failed with error code %d [%s]", errno,
+              zmq_strerror (errno)), NULL);
+      retval = FALSE;
+    }
+  }
+
+  /* watch the socket before binding or connecting, so the first
+   * listening or connect events are seen too */
+  if (retval && sink->socket_monitor
+      && !gst_zmq_monitor_add_socket (sink->socket_monitor, socket)) {
+    gst_zmq_monitor_free (sink->socket_monitor);
+    sink->socket_monitor = NULL;
+  }
+
+  for (i = 0; retval && sink->endpoints[i]; i++)
+    retval = gst_zmq_sink_check_transport (sink, sink->endpoints[i], FALSE)
+        && gst_zmq_sink_attach (sink, stripe, sink->endpoints[i],
+        sink->bound, FALSE);
+
+  return retval;
+}
+
 static gboolean
 gst_zmq_sink_start (GstBaseSink * basesink)
 {
   gboolean retval = TRUE;
 
   GstZmqSink *sink;
+  guint i;
 
   sink = GST_ZMQ_SINK (basesink);
 
-  int rc;
-
   GST_DEBUG_OBJECT (sink, "starting");
 
-  sink->socket = zmq_socket (sink->context, ZMQ_PUB);
-  if (!sink->socket) {
-    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
-        ("zmq_socket() failed with error code %d [%s]", errno,
+  GST_BASE_SINK_PREROLL_LOCK (sink);
+
+  gst_zmq_stats_reset (&sink->stats);
+  sink->seqnum = 0;
+  sink->sender = g_random_int ();
+  sink->compress_skip = 0;
+  sink->compress_backoff = 0;
+
+  /* a context of its own each time, as libzmq only honours the number
+   * of I/O threads, one per stripe, before the first socket is created */
+  sink->context = zmq_ctx_new ();
+  if (!sink->context) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
+        ("zmq_ctx_new() failed with error code %d [%s]", errno,
             zmq_strerror (errno)), NULL);
-  } else {
-    if (sink->bind) {
-      GST_DEBUG ("binding to endpoint %s", sink->endpoint);
-      rc = zmq_bind (sink->socket, sink->endpoint);
-      if (rc) {
-        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
-            ("zmq_bind() to endpoint \"%s\" failed with error code %d [%s]",
-                sink->endpoint, errno, zmq_strerror (errno)), NULL);
-        retval = FALSE;
-      }
-    } else {
-      GST_DEBUG ("connecting to endpoint %s", sink->endpoint);
-      rc = zmq_connect (sink->socket, sink->endpoint);
-      if (rc) {
-        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
-            ("zmq_connect() to endpoint \"%s\" failed with error code %d [%s]",
-                sink->endpoint, errno, zmq_strerror (errno)), NULL);
-        retval = FALSE;
-      }
-    }
+    GST_BASE_SINK_PREROLL_UNLOCK (sink);
+    return FALSE;
   }
+  if (sink->stripes > 1)
+    zmq_ctx_set (sink->context, ZMQ_IO_THREADS, sink->stripes);
+
+  /* changes from here on are applied by set_property() */
+  g_atomic_int_set (&sink->reconfigure, FALSE);
+  GST_OBJECT_LOCK (sink);
+  sink->endpoints = gst_zmq_endpoints_parse (sink->endpoint);
+  sink->bound = sink->bind;
+  GST_OBJECT_UNLOCK (sink);
+  sink->attached = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+
+  if (!sink->endpoints[0]) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND,
+        ("no endpoint to send to"), NULL);
+    retval = FALSE;
+  }
+
+  if (sink->monitor)
+    sink->socket_monitor = gst_zmq_monitor_new (GST_ELEMENT (sink),
+        sink->context, &sink->stats);
+
+  for (i = 0; i < sink->stripes && retval; i++)
+    retval = gst_zmq_sink_open_socket (sink, i);
+
+  if (sink->socket_monitor && !gst_zmq_monitor_start (sink->socket_monitor)) {
+    gst_zmq_monitor_free (sink->socket_monitor);
+    sink->socket_monitor = NULL;
+  }
+
+  GST_BASE_SINK_PREROLL_UNLOCK (sink);
+
+  /* basesink does not stop what failed to start */
+  if (!retval)
+    gst_zmq_sink_stop (basesink);
 
   return retval;
 }
@@ -275,19 +1130,43 @@ gst_zmq_sink_stop (GstBaseSink * basesink)
   gboolean retval = TRUE;
 
   GstZmqSink *sink;
+  guint i;
 
   sink = GST_ZMQ_SINK (basesink);
 
   GST_DEBUG_OBJECT (sink, "stopping");
 
-  int rc = zmq_close (sink->socket);
+  GST_BASE_SINK_PREROLL_LOCK (sink);
 
-  if (rc) {
-    GST_ELEMENT_WARNING (sink, RESOURCE, CLOSE,
-        ("zmq_close() failed with error code %d [%s]", errno, strerror (errno)),
-        NULL);
-    retval = FALSE;
+  gst_zmq_monitor_free (sink->socket_monitor);
+  sink->socket_monitor = NULL;
+
+  for (i = 0; i < sink->n_sockets; i++) {
+    int rc = zmq_close (sink->sockets[i]);
+
+    if (rc) {
+      GST_ELEMENT_WARNING (sink, RESOURCE, CLOSE,
+          ("zmq_close() failed with error code %d [%s]", errno,
+              strerror (errno)), NULL);
+      retval = FALSE;
+    }
+  }
+  sink->n_sockets = 0;
+
+  g_strfreev (sink->endpoints);
+  sink->endpoints = NULL;
+  if (sink->attached) {
+    g_hash_table_destroy (sink->attached);
+    sink->attached = NULL;
+  }
+
+  /* waits for the sockets' linger period to pass */
+  if (sink->context) {
+    zmq_ctx_destroy (sink->context);
+    sink->context = NULL;
   }
 
+  GST_BASE_SINK_PREROLL_UNLOCK (sink);
+
   return retval;
 }
@@ -27,6 +27,12 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
 
+#include "gstzmq.h"
+#include "gstzmqcompress.h"
+#include "gstzmqmonitor.h"
+#include "gstzmqstats.h"
+#include "gstzmqtracer.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_ZMQ_SINK \
@@ -43,6 +49,11 @@ G_BEGIN_DECLS
 typedef struct _GstZmqSink GstZmqSink;
 typedef struct _GstZmqSinkClass GstZmqSinkClass;
 
+typedef enum {
+  GST_ZMQ_SINK_SOCKET_TYPE_PUB,
+  GST_ZMQ_SINK_SOCKET_TYPE_RADIO
+} GstZmqSinkSocketType;
+
 typedef enum {
   GST_ZMQ_SINK_OPEN             = (GST_ELEMENT_FLAG_LAST << 0),
 
@@ -55,10 +66,49 @@ struct _GstZmqSink {
   // properties
   gchar *endpoint;
   gboolean bind;
+  GstZmqSinkSocketType socket_type;
+  gchar *group;
+  gint multicast_rate;
+  gint multicast_hops;
+  gboolean stamp;
+  guint stripes;
+  GstZmqCompression compression;
+  gint compression_level;
+  guint compression_budget;
+  gboolean monitor;
+  gint reconnect_ivl;
+  gint reconnect_ivl_max;
+  gint heartbeat_ivl;
+  gint heartbeat_timeout;
+  gint heartbeat_ttl;
+
+  guint64 seqnum;
+  guint32 sender;
+
+  // compression
+  guint8 *scratch;
+  gsize scratch_size;
+  guint compress_skip;
+  guint compress_backoff;
   
+  GstZmqStats stats;
+  GstZmqSinkTiming timing;
+
   // zmq stuff
   void *context;
-  void *socket;
+  void *sockets[ZMQ_MAX_STRIPES];
+  guint n_sockets;
+
+  // what the sockets are bound or connected to; set_property() applies
+  // changes itself, holding the preroll lock render() runs with
+  gchar **endpoints;
+  gboolean bound;
+  gint reconfigure;
+  // "<stripe> <address>" to what that stripe's socket has to unbind or
+  // disconnect, which for a wildcard bind is the address it resolved to
+  GHashTable *attached;
+
+  GstZmqMonitor *socket_monitor;
 };
 
 struct _GstZmqSinkClass {
@@ -44,6 +44,9 @@
 #endif
 
 #include "gstzmq.h"
+#include "gstzmqcompress.h"
+#include "gstzmqframing.h"
+#include "gstzmqmeta.h"
 #include "gstzmqsrc.h"
 
 GST_DEBUG_CATEGORY_STATIC (zmqsrc_debug);
@@ -59,23 +62,66 @@ enum
   PROP_0,
   PROP_ENDPOINT,
   PROP_BIND,
-  PROP_IS_LIVE
+  PROP_SOCKET_TYPE,
+  PROP_GROUP,
+  PROP_MULTICAST_RATE,
+  PROP_STRIPES,
+  PROP_IS_LIVE,
+  PROP_MAX_MESSAGE_SIZE,
+  PROP_CLOCK_OFFSET,
+  PROP_MONITOR,
+  PROP_RECONNECT_IVL,
+  PROP_RECONNECT_IVL_MAX,
+  PROP_HEARTBEAT_IVL,
+  PROP_HEARTBEAT_TIMEOUT,
+  PROP_HEARTBEAT_TTL,
+  PROP_STALL_TIMEOUT,
+  PROP_EOS_ON_STALL,
+  PROP_STATS,
+  PROP_STATS_INTERVAL
 };
 
 #define gst_zmq_src_parent_class parent_class
 G_DEFINE_TYPE (GstZmqSrc, gst_zmq_src, GST_TYPE_PUSH_SRC);
 
+#define GST_TYPE_ZMQ_SRC_SOCKET_TYPE (gst_zmq_src_socket_type_get_type ())
+static GType
+gst_zmq_src_socket_type_get_type (void)
+{
+  static GType socket_type = 0;
+  static const GEnumValue socket_types[] = {
+    {GST_ZMQ_SRC_SOCKET_TYPE_SUB, "SUB socket", "sub"},
+#ifdef HAVE_ZMQ_RADIO_DISH
+    {GST_ZMQ_SRC_SOCKET_TYPE_DISH, "DISH socket, for udp:// endpoints",
+        "dish"},
+#endif
+    {0, NULL, NULL}
+  };
+
+  if (!socket_type) {
+    socket_type = g_enum_register_static ("GstZmqSrcSocketType",
+        socket_types);
+  }
+  return socket_type;
+}
+
 static void gst_zmq_src_finalize (GObject * gobject);
 
 static GstCaps *gst_zmq_src_getcaps (GstBaseSrc * psrc, GstCaps * filter);
+static gboolean gst_zmq_src_decide_allocation (GstBaseSrc * bsrc,
+    GstQuery * query);
 
 static GstFlowReturn gst_zmq_src_create (GstPushSrc * psrc,
     GstBuffer ** outbuf);
 static gboolean gst_zmq_src_stop (GstBaseSrc * bsrc);
 static gboolean gst_zmq_src_start (GstBaseSrc * bsrc);
+static gboolean gst_zmq_src_unlock (GstBaseSrc * bsrc);
+static gboolean gst_zmq_src_unlock_stop (GstBaseSrc * bsrc);
 static GstStateChangeReturn gst_zmq_src_change_state (GstElement * element,
     GstStateChange transition);
 
+static void gst_zmq_src_apply_endpoints (GstZmqSrc * src);
+
 static void gst_zmq_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_zmq_src_get_property (GObject * object, guint prop_id,
@@ -100,24 +146,110 @@ gst_zmq_src_class_init (GstZmqSrcClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_ENDPOINT,
       g_param_spec_string ("endpoint", "Endpoint",
-          "ZeroMQ endpoint from which to receive buffers",
-          ZMQ_DEFAULT_ENDPOINT_CLIENT,
-          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          "Comma separated ZeroMQ endpoints from which to receive buffers; "
+          "changes apply while streaming", ZMQ_DEFAULT_ENDPOINT_CLIENT,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class, PROP_BIND,
       g_param_spec_boolean ("bind", "Bind",
-          "If true, bind to the endpoint (be the \"server\")",
-          ZMQ_DEFAULT_BIND_SRC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          "If true, bind to the endpoints (be the \"server\")",
+          ZMQ_DEFAULT_BIND_SRC, G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SOCKET_TYPE,
+      g_param_spec_enum ("socket-type", "Socket type",
+          "Type of ZeroMQ socket to receive on", GST_TYPE_ZMQ_SRC_SOCKET_TYPE,
+          GST_ZMQ_SRC_SOCKET_TYPE_SUB,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_GROUP,
+      g_param_spec_string ("group", "Group",
+          "Group to join on a DISH socket", ZMQ_DEFAULT_GROUP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MULTICAST_RATE,
+      g_param_spec_int ("multicast-rate", "Multicast rate",
+          "Maximum rate in kbit/s for pgm:// and epgm:// endpoints",
+          1, G_MAXINT, ZMQ_DEFAULT_MULTICAST_RATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STRIPES,
+      g_param_spec_uint ("stripes", "Stripes",
+          "Number of SUB sockets, on consecutive ports from the endpoint, "
+          "that a striped zmqsink splits every payload across", 1,
+          ZMQ_MAX_STRIPES, ZMQ_DEFAULT_STRIPES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class, PROP_IS_LIVE,
       g_param_spec_boolean ("is-live", "Is this a live source",
         "True if the element cannot produce data in PAUSED", TRUE,
         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_MESSAGE_SIZE,
+      g_param_spec_uint ("max-message-size", "Maximum message size",
+          "Size of pooled receive buffers in bytes, larger messages and "
+          "payloads are dropped (0 = learn from the stream, and drop "
+          "fragmented or compressed payloads over 64 MiB)", 0, G_MAXINT,
+          ZMQ_DEFAULT_MAX_MESSAGE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CLOCK_OFFSET,
+      g_param_spec_int64 ("clock-offset", "Clock offset",
+          "Sender wall clock minus receiver wall clock in ns, used to correct "
+          "the latency of stamped messages", G_MININT64, G_MAXINT64,
+          ZMQ_DEFAULT_CLOCK_OFFSET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MONITOR,
+      g_param_spec_boolean ("monitor", "Monitor",
+          "Post element messages for connection events on the socket",
+          ZMQ_DEFAULT_MONITOR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_IVL,
+      g_param_spec_int ("reconnect-ivl", "Reconnect interval",
+          "Initial interval in ms between attempts to reconnect to a peer "
+          "(-1 = never reconnect)", -1, G_MAXINT, ZMQ_DEFAULT_RECONNECT_IVL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_IVL_MAX,
+      g_param_spec_int ("reconnect-ivl-max", "Maximum reconnect interval",
+          "Upper bound in ms for the exponentially growing reconnect "
+          "interval (0 = do not grow)", 0, G_MAXINT,
+          ZMQ_DEFAULT_RECONNECT_IVL_MAX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+#ifdef ZMQ_HEARTBEAT_IVL
+  g_object_class_install_property (gobject_class, PROP_HEARTBEAT_IVL,
+      g_param_spec_int ("heartbeat-ivl", "Heartbeat interval",
+          "Interval in ms between ZMTP heartbeats to peers (0 = disabled)",
+          0, G_MAXINT, ZMQ_DEFAULT_HEARTBEAT_IVL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_HEARTBEAT_TIMEOUT,
+      g_param_spec_int ("heartbeat-timeout", "Heartbeat timeout",
+          "Time in ms without traffic after a heartbeat before a peer is "
+          "considered dead (0 = heartbeat-ivl)", 0, G_MAXINT,
+          ZMQ_DEFAULT_HEARTBEAT_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_HEARTBEAT_TTL,
+      g_param_spec_int ("heartbeat-ttl", "Heartbeat TTL",
+          "Timeout in ms the peer should apply to our heartbeats "
+          "(0 = peer decides)", 0, 6553599, ZMQ_DEFAULT_HEARTBEAT_TTL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+#endif
+  g_object_class_install_property (gobject_class, PROP_STALL_TIMEOUT,
+      g_param_spec_uint ("stall-timeout", "Stall timeout",
+          "Post a stream-stalled element message after this many ms without "
+          "a message (0 = disabled)", 0, G_MAXUINT, ZMQ_DEFAULT_STALL_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_EOS_ON_STALL,
+      g_param_spec_boolean ("eos-on-stall", "EOS on stall",
+          "End the stream when it stalls", ZMQ_DEFAULT_EOS_ON_STALL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Counters and message size histogram for received messages",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics interval",
+          "Post the stats as an element message every this many ms "
+          "(0 = disabled)", 0, G_MAXUINT, ZMQ_DEFAULT_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&srctemplate));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "ZeroMQ source", "Source/Network",
-      "Receive data on ZeroMQ SUB socket",
+      "Receive data on ZeroMQ SUB or DISH socket",
       "Mark J. Howell <m0ppy at hypgnosys dot org>");
 
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_zmq_src_change_state);
@@ -125,6 +257,10 @@ gst_zmq_src_class_init (GstZmqSrcClass * klass)
   gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_zmq_src_getcaps);
   gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_zmq_src_start);
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_zmq_src_stop);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_zmq_src_unlock);
+  gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_zmq_src_unlock_stop);
+  gstbasesrc_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_zmq_src_decide_allocation);
 
   gstpush_src_class->create = GST_DEBUG_FUNCPTR (gst_zmq_src_create);
 
@@ -136,14 +272,29 @@ gst_zmq_src_init (GstZmqSrc * this)
 {
   this->endpoint = g_strdup (ZMQ_DEFAULT_ENDPOINT_CLIENT);
   this->bind = ZMQ_DEFAULT_BIND_SRC;
-  this->context = zmq_ctx_new ();
+  this->socket_type = GST_ZMQ_SRC_SOCKET_TYPE_SUB;
+  this->group = g_strdup (ZMQ_DEFAULT_GROUP);
+  this->multicast_rate = ZMQ_DEFAULT_MULTICAST_RATE;
+  this->stripes = ZMQ_DEFAULT_STRIPES;
+  this->max_message_size = ZMQ_DEFAULT_MAX_MESSAGE_SIZE;
+  this->clock_offset = ZMQ_DEFAULT_CLOCK_OFFSET;
+  this->monitor = ZMQ_DEFAULT_MONITOR;
+  this->reconnect_ivl = ZMQ_DEFAULT_RECONNECT_IVL;
+  this->reconnect_ivl_max = ZMQ_DEFAULT_RECONNECT_IVL_MAX;
+  this->heartbeat_ivl = ZMQ_DEFAULT_HEARTBEAT_IVL;
+  this->heartbeat_timeout = ZMQ_DEFAULT_HEARTBEAT_TIMEOUT;
+  this->heartbeat_ttl = ZMQ_DEFAULT_HEARTBEAT_TTL;
+  this->stall_timeout = ZMQ_DEFAULT_STALL_TIMEOUT;
+  this->eos_on_stall = ZMQ_DEFAULT_EOS_ON_STALL;
+  this->stats.interval = ZMQ_DEFAULT_STATS_INTERVAL * GST_MSECOND;
 }
 
 static void
 gst_zmq_src_finalize (GObject * gobject)
 {
   GstZmqSrc *this = GST_ZMQ_SRC (gobject);
-  zmq_ctx_destroy (this->context);
+  g_free (this->endpoint);
+  g_free (this->group);
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
 }
 
@@ -162,16 +313,546 @@ gst_zmq_src_getcaps (GstBaseSrc * bsrc, GstCaps * filter)
   return caps;
 }
 
-static GstFlowReturn
-gst_zmq_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
+static gboolean
+gst_zmq_src_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
 {
   GstZmqSrc *src;
-  GstFlowReturn retval = GST_FLOW_OK;
+  GstBufferPool *pool = NULL;
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+  GstStructure *config;
+  GstCaps *caps;
+  guint size = 0, min = 0, max = 0, msg_size;
+  gboolean update_pool, update_allocator;
+
+  src = GST_ZMQ_SRC (bsrc);
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (gst_query_get_n_allocation_params (query) > 0) {
+    gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+    update_allocator = TRUE;
+  } else {
+    gst_allocation_params_init (&params);
+    update_allocator = FALSE;
+  }
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+    update_pool = TRUE;
+  } else {
+    update_pool = FALSE;
+  }
+
+  /* leave room for a header in front of the largest payload, it is
+   * stripped again after receiving */
+  GST_OBJECT_LOCK (src);
+  msg_size = src->max_message_size ?
+      src->max_message_size + GST_ZMQ_HEADER_SIZE : src->learned_size;
+  GST_OBJECT_UNLOCK (src);
+
+  /* until the first message tells us how big they are, there is nothing
+   * sensible to size a pool with */
+  if (msg_size > 0) {
+    size = MAX (size, msg_size);
+
+    if (pool == NULL)
+      pool = gst_buffer_pool_new ();
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, size, min, max);
+    gst_buffer_pool_config_set_allocator (config, allocator, &params);
+
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_DEBUG_OBJECT (src, "downstream pool rejected config, using our own");
+      gst_object_unref (pool);
+      pool = gst_buffer_pool_new ();
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_set_params (config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+      if (!gst_buffer_pool_set_config (pool, config)) {
+        GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS,
+            ("failed to configure buffer pool for %u byte messages", size),
+            NULL);
+        gst_object_unref (pool);
+        if (allocator)
+          gst_object_unref (allocator);
+        return FALSE;
+      }
+    }
+
+    if (update_pool)
+      gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+    else
+      gst_query_add_allocation_pool (query, pool, size, min, max);
+  } else {
+    /* basesrc would activate a pool left in the query unconfigured; the
+     * first message renegotiates once its size is known */
+    if (update_pool)
+      gst_query_remove_nth_allocation_pool (query, 0);
+    if (pool) {
+      gst_object_unref (pool);
+      pool = NULL;
+    }
+    size = 0;
+  }
+
+  if (update_allocator)
+    gst_query_set_nth_allocation_param (query, 0, allocator, &params);
+  else
+    gst_query_add_allocation_param (query, allocator, &params);
+
+  /* only a pool configured above is ours to receive into */
+  GST_OBJECT_LOCK (src);
+  src->pool_size = size;
+  GST_OBJECT_UNLOCK (src);
+
+  GST_DEBUG_OBJECT (src, "using pool %" GST_PTR_FORMAT " of %u byte buffers",
+      pool, size);
+
+  if (allocator)
+    gst_object_unref (allocator);
+  if (pool)
+    gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_zmq_src_recv_error (GstZmqSrc * src)
+{
+  if (g_atomic_int_get (&src->flushing)) {
+    GST_DEBUG_OBJECT (src, "flushing");
+    return GST_FLOW_FLUSHING;
+  }
+
+  if (ENOTSOCK == errno) {
+    GST_DEBUG_OBJECT (src, "Connection closed");
+    return GST_FLOW_EOS;
+  }
+
+  GST_ZMQ_STAT_INC (src->stats.errors);
+
+  GST_ELEMENT_ERROR (src, RESOURCE, READ,
+      ("zmq_msg_recv() failed with error code %d [%s]", errno,
+          zmq_strerror (errno)), NULL);
+  return GST_FLOW_ERROR;
+}
+
+/* called whenever a receive times out; returns TRUE if the stream should
+ * end because the publisher went silent */
+static gboolean
+gst_zmq_src_check_stall (GstZmqSrc * src)
+{
+  GstClockTime now, silence;
+
+  if (src->stall_timeout == 0 || src->stalled)
+    return FALSE;
+
+  now = gst_util_get_timestamp ();
+  silence = now - src->last_message_time;
+  if (silence < src->stall_timeout * GST_MSECOND)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (src, "stream stalled after %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (silence));
+
+  src->stalled = TRUE;
+  gst_element_post_message (GST_ELEMENT (src),
+      gst_message_new_element (GST_OBJECT (src),
+          gst_structure_new ("stream-stalled",
+              "silence", G_TYPE_UINT64, silence,
+              "timestamp", G_TYPE_UINT64, gst_zmq_wall_clock_now (), NULL)));
+
+  return src->eos_on_stall;
+}
+
+static void
+gst_zmq_src_mark_received (GstZmqSrc * src, GstClockTime now)
+{
+  if (G_UNLIKELY (src->stalled)) {
+    GST_DEBUG_OBJECT (src, "stream resumed");
+    src->stalled = FALSE;
+    gst_element_post_message (GST_ELEMENT (src),
+        gst_message_new_element (GST_OBJECT (src),
+            gst_structure_new ("stream-resumed",
+                "silence", G_TYPE_UINT64, now - src->last_message_time,
+                "timestamp", G_TYPE_UINT64, gst_zmq_wall_clock_now (),
+                NULL)));
+  }
+  src->last_message_time = now;
+}
+
+/* account for the header a zmqsink with stamp=true puts in front of the
+ * payload, and attach the timing to the outgoing buffer */
+static void
+gst_zmq_src_handle_header (GstZmqSrc * src, GstBuffer * buf,
+    const GstZmqHeader * header, guint64 receive_time)
+{
+  gint64 latency;
+
+  /* seqnums only follow on from the same sender */
+  if (src->have_seqnum && header->sender != src->last_sender)
+    src->have_seqnum = FALSE;
+
+  if (src->have_seqnum && header->seqnum > src->last_seqnum + 1) {
+    GST_ZMQ_STAT_ADD (src->stats.sequence_gaps,
+        header->seqnum - src->last_seqnum - 1);
+    GST_DEBUG_OBJECT (src, "missed %" G_GUINT64_FORMAT " messages",
+        header->seqnum - src->last_seqnum - 1);
+  }
+  src->last_seqnum = header->seqnum;
+  src->last_sender = header->sender;
+  src->have_seqnum = TRUE;
+
+  if (!(header->flags & GST_ZMQ_HEADER_FLAG_STAMPED))
+    return;
+
+  GST_OBJECT_LOCK (src);
+  /* send_time is on the sender's clock, clock_offset ahead of ours */
+  latency = (gint64) (receive_time - header->send_time) + src->clock_offset;
+  GST_OBJECT_UNLOCK (src);
+
+  gst_zmq_histogram_add (&src->stats.latency, MAX (latency, 0));
+  gst_buffer_add_zmq_meta (buf, header->seqnum, header->send_time,
+      receive_time, latency);
+
+  GST_LOG_OBJECT (src, "message %" G_GUINT64_FORMAT " latency %"
+      G_GINT64_FORMAT " ns", header->seqnum, latency);
+}
+
+/* output buffers come from the negotiated pool when they fit, otherwise
+ * from the negotiated allocator */
+static GstBuffer *
+gst_zmq_src_alloc_buffer (gsize size, gpointer user_data)
+{
+  GstZmqSrc *src = GST_ZMQ_SRC (user_data);
+  GstBufferPool *pool;
+  GstBuffer *buf = NULL;
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstFlowReturn ret;
+  guint pool_size, max_message_size;
+
+  GST_OBJECT_LOCK (src);
+  pool_size = src->pool_size;
+  max_message_size = src->max_message_size;
+  GST_OBJECT_UNLOCK (src);
+
+  pool = gst_base_src_get_buffer_pool (GST_BASE_SRC (src));
+  if (pool && pool_size > 0 && size <= pool_size) {
+    ret = gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+    if (ret == GST_FLOW_OK) {
+      gst_buffer_resize (buf, 0, size);
+    } else {
+      /* the pool is flushing or was deactivated; the caller returns this
+       * rather than carrying on without a buffer */
+      GST_DEBUG_OBJECT (src, "could not acquire a buffer: %s",
+          gst_flow_get_name (ret));
+      src->alloc_ret = ret;
+    }
+    gst_object_unref (pool);
+    return buf;
+  }
+  if (pool)
+    gst_object_unref (pool);
+
+  /* remember the largest message seen so the next negotiation sizes the
+   * pool to fit, and ask for that negotiation to happen */
+  if (max_message_size == 0 && size > src->learned_size) {
+    GST_OBJECT_LOCK (src);
+    src->learned_size = GST_ROUND_UP_N (size, 4096);
+    GST_OBJECT_UNLOCK (src);
+    GST_DEBUG_OBJECT (src, "learned message size %u, reconfiguring pool",
+        src->learned_size);
+    gst_pad_mark_reconfigure (GST_BASE_SRC_PAD (src));
+  }
+
+  gst_base_src_get_allocator (GST_BASE_SRC (src), &allocator, &params);
+  buf = gst_buffer_new_allocate (allocator, size, &params);
+  if (allocator)
+    gst_object_unref (allocator);
+
+  if (buf == NULL) {
+    GST_ZMQ_STAT_INC (src->stats.errors);
+    GST_ELEMENT_WARNING (src, RESOURCE, FAILED,
+        ("dropped message, could not allocate a %" G_GSIZE_FORMAT
+            " byte buffer", size), NULL);
+  }
+
+  return buf;
+}
+
+/* inflates a compressed payload into a new output buffer of the size the
+ * sender recorded; corrupt payloads are dropped with a warning */
+static GstBuffer *
+gst_zmq_src_decompress (GstZmqSrc * src, const GstZmqHeader * header,
+    const guint8 * data, gsize size)
+{
+  GstBuffer *buf;
   GstMapInfo map;
+  gboolean ok;
+
+  if (header->raw_size > src->reassembly.max_size) {
+    GST_ZMQ_STAT_INC (src->stats.errors);
+    GST_ELEMENT_WARNING (src, STREAM, DECODE,
+        ("dropped message %" G_GUINT64_FORMAT " claiming %" G_GUINT64_FORMAT
+            " uncompressed bytes", header->seqnum, header->raw_size), NULL);
+    return NULL;
+  }
 
-  src = GST_ZMQ_SRC (psrc);
+  buf = gst_zmq_src_alloc_buffer (header->raw_size, src);
+  if (buf == NULL)
+    return NULL;
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_WRITE)) {
+    GST_ZMQ_STAT_INC (src->stats.errors);
+    GST_ELEMENT_WARNING (src, RESOURCE, FAILED,
+        ("dropped message %" G_GUINT64_FORMAT ", could not map a %"
+            G_GUINT64_FORMAT " byte buffer", header->seqnum,
+            header->raw_size), NULL);
+    gst_buffer_unref (buf);
+    return NULL;
+  }
+  ok = gst_zmq_decompress (header->flags, data, size, map.data, map.size);
+  gst_buffer_unmap (buf, &map);
+
+  if (!ok) {
+    GST_ZMQ_STAT_INC (src->stats.errors);
+    GST_ELEMENT_WARNING (src, STREAM, DECODE,
+        ("dropped message %" G_GUINT64_FORMAT " that failed to decompress",
+            header->seqnum), NULL);
+    gst_buffer_unref (buf);
+    return NULL;
+  }
 
-  GST_LOG_OBJECT (src, "was asked for a buffer");
+  return buf;
+}
+
+/* decodes a reassembled compressed payload from where its fragments were
+ * put together straight into the output buffer */
+static GstBuffer *
+gst_zmq_src_decode (const GstZmqHeader * header, const guint8 * data,
+    gsize size, gpointer user_data)
+{
+  return gst_zmq_src_decompress (GST_ZMQ_SRC (user_data), header, data, size);
+}
+
+/* how long to poll for: the receive timeout, cut short so a stall is
+ * noticed when it is due rather than up to a whole timeout later */
+static long
+gst_zmq_src_poll_timeout (GstZmqSrc * src)
+{
+  GstClockTime deadline, now;
+
+  if (src->stall_timeout == 0 || src->stalled
+      || !GST_CLOCK_TIME_IS_VALID (src->last_message_time))
+    return src->receive_timeout;
+
+  deadline = src->last_message_time + src->stall_timeout * GST_MSECOND;
+  now = gst_util_get_timestamp ();
+  if (now >= deadline)
+    return 0;
+
+  /* round up, or the stall would not quite be due when the poll ends */
+  return MIN (src->receive_timeout,
+      (deadline - now + GST_MSECOND - 1) / GST_MSECOND);
+}
+
+/* returns a socket with a message waiting, or NULL with errno set to
+ * EAGAIN if none arrived within the receive timeout, or to EINTR when
+ * unlock() interrupted the wait; endpoint changes are applied here, in
+ * the thread that owns the sockets */
+static void *
+gst_zmq_src_wait (GstZmqSrc * src)
+{
+  zmq_pollitem_t items[ZMQ_MAX_STRIPES + 1];
+  guint i, stripe, n = src->n_sockets;
+  size_t size = sizeof (int);
+  int events, rc;
+
+  while (1) {
+    if (g_atomic_int_get (&src->flushing)) {
+      errno = EINTR;
+      return NULL;
+    }
+
+    if (g_atomic_int_get (&src->reconfigure))
+      gst_zmq_src_apply_endpoints (src);
+
+    /* while messages flow, take turns between the stripes without
+     * polling, so one busy stripe cannot hold back the others */
+    for (i = 1; i <= n; i++) {
+      stripe = (src->last_stripe + i) % n;
+      if (zmq_getsockopt (src->sockets[stripe], ZMQ_EVENTS, &events,
+              &size) == 0 && (events & ZMQ_POLLIN)) {
+        src->last_stripe = stripe;
+        src->timing.queued++;
+        return src->sockets[stripe];
+      }
+    }
+
+    for (i = 0; i < n; i++) {
+      items[i].socket = src->sockets[i];
+      items[i].fd = 0;
+      items[i].events = ZMQ_POLLIN;
+      items[i].revents = 0;
+    }
+    items[n].socket = src->wakeup_recv;
+    items[n].fd = 0;
+    items[n].events = ZMQ_POLLIN;
+    items[n].revents = 0;
+
+    rc = zmq_poll (items, n + 1, gst_zmq_src_poll_timeout (src));
+    /* a signal is no reason to fail, and unlock() is seen to at the top */
+    if (rc < 0 && errno == EINTR)
+      continue;
+    if (rc < 0)
+      return NULL;
+
+    /* woken up to stop or to change endpoints, see to it and wait on */
+    if (items[n].revents & ZMQ_POLLIN) {
+      while (zmq_recv (src->wakeup_recv, NULL, 0, ZMQ_DONTWAIT) >= 0);
+      continue;
+    }
+
+    for (i = 0; i < n; i++) {
+      if (items[i].revents & ZMQ_POLLIN) {
+        src->last_stripe = i;
+        return src->sockets[i];
+      }
+    }
+
+    errno = EAGAIN;
+    return NULL;
+  }
+}
+
+/* receive straight into a pooled buffer; only used when the application
+ * has promised an upper bound on the message size */
+static GstFlowReturn
+gst_zmq_src_recv_into_pool (GstZmqSrc * src, GstBufferPool * pool,
+    GstBuffer ** outbuf)
+{
+  GstFlowReturn retval;
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+  GstClockTime start, now, blocked = 0;
+  GstZmqHeader header;
+  guint64 receive_time = 0;
+  gboolean framed, tracing = GST_ZMQ_TRACING ();
+  void *socket;
+  int rc;
+
+  if (tracing)
+    start = gst_util_get_timestamp ();
+
+  retval = gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+  if (retval != GST_FLOW_OK)
+    return retval;
+
+  /* every pooled buffer is alike, so one that cannot be written cannot
+   * be received into at all */
+  if (!gst_buffer_map (buf, &map, GST_MAP_WRITE)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, FAILED,
+        ("could not map a pooled %" G_GSIZE_FORMAT " byte buffer for "
+            "writing", gst_buffer_get_size (buf)), NULL);
+    gst_buffer_unref (buf);
+    return GST_FLOW_ERROR;
+  }
+
+  if (tracing)
+    src->timing.alloc += gst_util_get_timestamp () - start;
+
+  while (1) {
+    start = gst_util_get_timestamp ();
+    socket = gst_zmq_src_wait (src);
+    if (tracing)
+      src->timing.wait += gst_util_get_timestamp () - start;
+    rc = socket ? zmq_recv (socket, map.data, map.size, 0) : -1;
+    blocked += gst_util_get_timestamp () - start;
+    if ((rc < 0) && (EAGAIN == errno)) {
+      GST_LOG_OBJECT (src, "No message available on socket");
+      GST_ZMQ_STAT_INC (src->stats.eagain);
+      if (gst_zmq_src_check_stall (src)) {
+        gst_buffer_unmap (buf, &map);
+        gst_buffer_unref (buf);
+        return GST_FLOW_EOS;
+      }
+      continue;
+    } else if (rc > (int) map.size) {
+      GST_ZMQ_STAT_INC (src->stats.errors);
+      GST_ELEMENT_WARNING (src, RESOURCE, READ,
+          ("dropped %d byte message larger than max-message-size %"
+              G_GSIZE_FORMAT, rc, map.size), NULL);
+      continue;
+    } else {
+      break;
+    }
+  }
+
+  if (rc < 0) {
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+    return gst_zmq_src_recv_error (src);
+  }
+
+  framed = gst_zmq_header_read (&header, map.data, rc);
+  if (framed)
+    receive_time = gst_zmq_wall_clock_now ();
+
+  if (tracing)
+    start = gst_util_get_timestamp ();
+
+  if (!framed) {
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_resize (buf, 0, rc);
+    *outbuf = buf;
+  } else if (header.flags & GST_ZMQ_HEADER_FLAG_FRAGMENT) {
+    /* the pooled buffer only held one fragment, it goes straight back */
+    *outbuf = gst_zmq_reassembly_push (&src->reassembly, &header,
+        map.data + header.header_size, rc - header.header_size);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  } else if (header.flags & GST_ZMQ_HEADER_FLAG_COMPRESSED) {
+    *outbuf = gst_zmq_src_decompress (src, &header,
+        map.data + header.header_size, rc - header.header_size);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  } else {
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_resize (buf, header.header_size, rc - header.header_size);
+    *outbuf = buf;
+  }
+
+  if (framed && *outbuf)
+    gst_zmq_src_handle_header (src, *outbuf, &header, receive_time);
+
+  now = gst_util_get_timestamp ();
+  if (tracing) {
+    src->timing.alloc += now - start;
+    src->timing.blocked += blocked;
+    src->timing.messages++;
+  }
+  gst_zmq_src_mark_received (src, now);
+  gst_zmq_stats_add_message (&src->stats, rc, blocked);
+  gst_zmq_stats_maybe_post (&src->stats, GST_ELEMENT (src), "zmqsrc-stats",
+      now);
+
+  if (*outbuf == NULL && src->alloc_ret != GST_FLOW_OK)
+    return src->alloc_ret;
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_zmq_src_recv_message (GstZmqSrc * src, GstBuffer ** outbuf)
+{
+  GstFlowReturn retval = GST_FLOW_OK;
+  GstMapInfo map;
+  GstClockTime start, now, blocked = 0;
+  gboolean tracing = GST_ZMQ_TRACING ();
+  void *socket;
 
   zmq_msg_t msg;
   int rc = zmq_msg_init (&msg);
@@ -179,14 +860,23 @@ gst_zmq_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
     GST_ELEMENT_ERROR (src, RESOURCE, FAILED,
         ("zmq_msg_init() failed with error code %d [%s]", errno,
             zmq_strerror (errno)), NULL);
-    retval = GST_FLOW_ERROR;
-    goto done;
+    return GST_FLOW_ERROR;
   }
 
   while (1) {
-    rc = zmq_msg_recv (&msg, src->socket, 0);
+    start = gst_util_get_timestamp ();
+    socket = gst_zmq_src_wait (src);
+    if (tracing)
+      src->timing.wait += gst_util_get_timestamp () - start;
+    rc = socket ? zmq_msg_recv (&msg, socket, 0) : -1;
+    blocked += gst_util_get_timestamp () - start;
     if ((rc < 0) && (EAGAIN == errno)) {
       GST_LOG_OBJECT (src, "No message available on socket");
+      GST_ZMQ_STAT_INC (src->stats.eagain);
+      if (gst_zmq_src_check_stall (src)) {
+        zmq_msg_close (&msg);
+        return GST_FLOW_EOS;
+      }
       continue;
     } else {
       break;
@@ -194,39 +884,142 @@ gst_zmq_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   }
 
   if (rc < 0) {
-    if (ENOTSOCK == errno) {
-      GST_DEBUG_OBJECT (src, "Connection closed");
-      retval = GST_FLOW_EOS;
-/*    } else if (EAGAIN == errno) {
-      GST_LOG_OBJECT (src, "No message available on socket");
-      g_print("w");*/
-    } else {
-      GST_ELEMENT_ERROR (src, RESOURCE, READ,
-          ("zmq_msg_recv() failed with error code %d [%s]", errno,
-              zmq_strerror (errno)), NULL);
-      retval = GST_FLOW_ERROR;
-    }
-    *outbuf = NULL;
+    retval = gst_zmq_src_recv_error (src);
     zmq_msg_close (&msg);
-    goto done;
+    return retval;
   }
   size_t msg_size = zmq_msg_size (&msg);
+  guint8 *msg_data = zmq_msg_data (&msg);
+  GstZmqHeader header;
+  guint64 receive_time = 0;
+  gboolean framed = gst_zmq_header_read (&header, msg_data, msg_size);
+
+  if (framed) {
+    receive_time = gst_zmq_wall_clock_now ();
+    msg_data += header.header_size;
+    msg_size -= header.header_size;
+  }
 
-  *outbuf = gst_buffer_new_and_alloc (msg_size);
-  gst_buffer_map (*outbuf, &map, GST_MAP_READWRITE);
+  if (tracing)
+    start = gst_util_get_timestamp ();
+
+  if (framed && (header.flags & GST_ZMQ_HEADER_FLAG_FRAGMENT)) {
+    *outbuf = gst_zmq_reassembly_push (&src->reassembly, &header, msg_data,
+        msg_size);
+  } else if (framed && (header.flags & GST_ZMQ_HEADER_FLAG_COMPRESSED)) {
+    *outbuf = gst_zmq_src_decompress (src, &header, msg_data, msg_size);
+  } else {
+    *outbuf = gst_zmq_src_alloc_buffer (msg_size, src);
+    if (*outbuf && !gst_buffer_map (*outbuf, &map, GST_MAP_WRITE)) {
+      GST_ZMQ_STAT_INC (src->stats.errors);
+      GST_ELEMENT_WARNING (src, RESOURCE, FAILED,
+          ("dropped message, could not map a %" G_GSIZE_FORMAT
+              " byte buffer", msg_size), NULL);
+      gst_buffer_unref (*outbuf);
+      *outbuf = NULL;
+    } else if (*outbuf) {
+      memcpy (map.data, msg_data, msg_size);
+
+      gst_buffer_unmap (*outbuf, &map);
+    }
+  }
+
+  /* a pool that stopped handing out buffers means we are shutting down,
+   * say so now rather than on the next receive */
+  if (*outbuf == NULL && src->alloc_ret != GST_FLOW_OK)
+    retval = src->alloc_ret;
 
-  memcpy (map.data, zmq_msg_data (&msg), msg_size);
+  if (framed && *outbuf)
+    gst_zmq_src_handle_header (src, *outbuf, &header, receive_time);
 
-  gst_buffer_unmap (*outbuf, &map);
+  gst_zmq_stats_add_message (&src->stats, zmq_msg_size (&msg), blocked);
 
   zmq_msg_close (&msg);
 
-  GST_LOG_OBJECT (src, "delivered a buffer of size %" G_GSIZE_FORMAT " bytes",
-      msg_size);
-done:
+  now = gst_util_get_timestamp ();
+  if (tracing) {
+    src->timing.alloc += now - start;
+    src->timing.blocked += blocked;
+    src->timing.messages++;
+  }
+  gst_zmq_src_mark_received (src, now);
+  gst_zmq_stats_maybe_post (&src->stats, GST_ELEMENT (src), "zmqsrc-stats",
+      now);
+
+  return retval;
+}
+
+static GstFlowReturn
+gst_zmq_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
+{
+  GstZmqSrc *src;
+  GstFlowReturn retval = GST_FLOW_OK;
+  GstBufferPool *pool;
+  guint pool_size, max_message_size;
+  gboolean tracing = GST_ZMQ_TRACING ();
+
+  src = GST_ZMQ_SRC (psrc);
+
+  GST_LOG_OBJECT (src, "was asked for a buffer");
+
+  *outbuf = NULL;
+
+  if (tracing)
+    memset (&src->timing, 0, sizeof (src->timing));
+
+  /* silence is measured from the first time we were asked for data */
+  if (!GST_CLOCK_TIME_IS_VALID (src->last_message_time))
+    src->last_message_time = gst_util_get_timestamp ();
+
+  /* set_property() writes these from other threads */
+  GST_OBJECT_LOCK (src);
+  pool_size = src->pool_size;
+  max_message_size = src->max_message_size;
+  GST_OBJECT_UNLOCK (src);
+
+  src->reassembly.max_size = max_message_size ? max_message_size :
+      ZMQ_DEFAULT_MAX_PAYLOAD_SIZE;
+
+  pool = gst_base_src_get_buffer_pool (GST_BASE_SRC (src));
+
+  /* a fragment of a larger payload leaves *outbuf unset until the payload
+   * is complete */
+  while (retval == GST_FLOW_OK && *outbuf == NULL) {
+    src->alloc_ret = GST_FLOW_OK;
+    if (pool && max_message_size > 0 && pool_size >= max_message_size)
+      retval = gst_zmq_src_recv_into_pool (src, pool, outbuf);
+    else
+      retval = gst_zmq_src_recv_message (src, outbuf);
+  }
+
+  if (pool)
+    gst_object_unref (pool);
+
+  if (*outbuf) {
+    GST_LOG_OBJECT (src, "delivered a buffer of size %" G_GSIZE_FORMAT
+        " bytes", gst_buffer_get_size (*outbuf));
+    if (tracing)
+      gst_zmq_tracer_log_create (GST_ELEMENT (src), &src->timing,
+          gst_buffer_get_size (*outbuf),
+          gst_zmq_reassembly_pending (&src->reassembly));
+  }
+
   return retval;
 }
 
+/* has the streaming thread apply a new endpoint or bind setting, waking it
+ * up if it is waiting for messages */
+static void
+gst_zmq_src_request_reconfigure (GstZmqSrc * src)
+{
+  g_atomic_int_set (&src->reconfigure, TRUE);
+
+  GST_OBJECT_LOCK (src);
+  if (src->wakeup_send)
+    zmq_send (src->wakeup_send, NULL, 0, ZMQ_DONTWAIT);
+  GST_OBJECT_UNLOCK (src);
+}
+
 static void
 gst_zmq_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -239,16 +1032,78 @@ gst_zmq_src_set_property (GObject * object, guint prop_id,
         g_warning ("endpoint property cannot be NULL");
         break;
       }
+      GST_OBJECT_LOCK (zmqsrc);
       g_free (zmqsrc->endpoint);
       zmqsrc->endpoint = g_strdup (g_value_get_string (value));
+      GST_OBJECT_UNLOCK (zmqsrc);
+      gst_zmq_src_request_reconfigure (zmqsrc);
       break;
     case PROP_BIND:
+      GST_OBJECT_LOCK (zmqsrc);
       zmqsrc->bind = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (zmqsrc);
+      gst_zmq_src_request_reconfigure (zmqsrc);
+      break;
+    case PROP_SOCKET_TYPE:
+      zmqsrc->socket_type = g_value_get_enum (value);
+      break;
+    case PROP_GROUP:
+      if (!g_value_get_string (value)) {
+        g_warning ("group property cannot be NULL");
+        break;
+      }
+      g_free (zmqsrc->group);
+      zmqsrc->group = g_strdup (g_value_get_string (value));
+      break;
+    case PROP_MULTICAST_RATE:
+      zmqsrc->multicast_rate = g_value_get_int (value);
+      break;
+    case PROP_STRIPES:
+      zmqsrc->stripes = g_value_get_uint (value);
       break;
     case PROP_IS_LIVE:
       gst_base_src_set_live (GST_BASE_SRC (object),
               g_value_get_boolean (value));
       break;
+    case PROP_MAX_MESSAGE_SIZE:
+      GST_OBJECT_LOCK (zmqsrc);
+      zmqsrc->max_message_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (zmqsrc);
+      gst_pad_mark_reconfigure (GST_BASE_SRC_PAD (zmqsrc));
+      break;
+    case PROP_CLOCK_OFFSET:
+      GST_OBJECT_LOCK (zmqsrc);
+      zmqsrc->clock_offset = g_value_get_int64 (value);
+      GST_OBJECT_UNLOCK (zmqsrc);
+      break;
+    case PROP_MONITOR:
+      zmqsrc->monitor = g_value_get_boolean (value);
+      break;
+    case PROP_RECONNECT_IVL:
+      zmqsrc->reconnect_ivl = g_value_get_int (value);
+      break;
+    case PROP_RECONNECT_IVL_MAX:
+      zmqsrc->reconnect_ivl_max = g_value_get_int (value);
+      break;
+    case PROP_HEARTBEAT_IVL:
+      zmqsrc->heartbeat_ivl = g_value_get_int (value);
+      break;
+    case PROP_HEARTBEAT_TIMEOUT:
+      zmqsrc->heartbeat_timeout = g_value_get_int (value);
+      break;
+    case PROP_HEARTBEAT_TTL:
+      zmqsrc->heartbeat_ttl = g_value_get_int (value);
+      break;
+    case PROP_STALL_TIMEOUT:
+      zmqsrc->stall_timeout = g_value_get_uint (value);
+      break;
+    case PROP_EOS_ON_STALL:
+      zmqsrc->eos_on_stall = g_value_get_boolean (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      __atomic_store_n (&zmqsrc->stats.interval,
+          g_value_get_uint (value) * GST_MSECOND, __ATOMIC_RELAXED);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -264,14 +1119,70 @@ gst_zmq_src_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_ENDPOINT:
+      GST_OBJECT_LOCK (zmqsrc);
       g_value_set_string (value, zmqsrc->endpoint);
+      GST_OBJECT_UNLOCK (zmqsrc);
       break;
     case PROP_BIND:
       g_value_set_boolean (value, zmqsrc->bind);
       break;
+    case PROP_SOCKET_TYPE:
+      g_value_set_enum (value, zmqsrc->socket_type);
+      break;
+    case PROP_GROUP:
+      g_value_set_string (value, zmqsrc->group);
+      break;
+    case PROP_MULTICAST_RATE:
+      g_value_set_int (value, zmqsrc->multicast_rate);
+      break;
+    case PROP_STRIPES:
+      g_value_set_uint (value, zmqsrc->stripes);
+      break;
     case PROP_IS_LIVE:
       g_value_set_boolean (value, gst_base_src_is_live (GST_BASE_SRC (object)));
       break;
+    case PROP_MAX_MESSAGE_SIZE:
+      GST_OBJECT_LOCK (zmqsrc);
+      g_value_set_uint (value, zmqsrc->max_message_size);
+      GST_OBJECT_UNLOCK (zmqsrc);
+      break;
+    case PROP_CLOCK_OFFSET:
+      GST_OBJECT_LOCK (zmqsrc);
+      g_value_set_int64 (value, zmqsrc->clock_offset);
+      GST_OBJECT_UNLOCK (zmqsrc);
+      break;
+    case PROP_MONITOR:
+      g_value_set_boolean (value, zmqsrc->monitor);
+      break;
+    case PROP_RECONNECT_IVL:
+      g_value_set_int (value, zmqsrc->reconnect_ivl);
+      break;
+    case PROP_RECONNECT_IVL_MAX:
+      g_value_set_int (value, zmqsrc->reconnect_ivl_max);
+      break;
+    case PROP_HEARTBEAT_IVL:
+      g_value_set_int (value, zmqsrc->heartbeat_ivl);
+      break;
+    case PROP_HEARTBEAT_TIMEOUT:
+      g_value_set_int (value, zmqsrc->heartbeat_timeout);
+      break;
+    case PROP_HEARTBEAT_TTL:
+      g_value_set_int (value, zmqsrc->heartbeat_ttl);
+      break;
+    case PROP_STALL_TIMEOUT:
+      g_value_set_uint (value, zmqsrc->stall_timeout);
+      break;
+    case PROP_EOS_ON_STALL:
+      g_value_set_boolean (value, zmqsrc->eos_on_stall);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_zmq_stats_get_structure (&zmqsrc->stats, "zmqsrc-stats"));
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value,
+          GST_ZMQ_STAT_GET (zmqsrc->stats.interval) / GST_MSECOND);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -288,6 +1199,36 @@ gst_zmq_src_start (GstBaseSrc * bsrc)
   return TRUE;
 }
 
+static gboolean
+gst_zmq_src_unlock (GstBaseSrc * bsrc)
+{
+  GstZmqSrc *src = GST_ZMQ_SRC (bsrc);
+
+  GST_DEBUG_OBJECT (src, "unlocking");
+
+  g_atomic_int_set (&src->flushing, TRUE);
+
+  /* the wakeup pipe is written from more than one thread */
+  GST_OBJECT_LOCK (src);
+  if (src->wakeup_send)
+    zmq_send (src->wakeup_send, NULL, 0, ZMQ_DONTWAIT);
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static gboolean
+gst_zmq_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstZmqSrc *src = GST_ZMQ_SRC (bsrc);
+
+  GST_DEBUG_OBJECT (src, "unlock stopped");
+
+  g_atomic_int_set (&src->flushing, FALSE);
+
+  return TRUE;
+}
+
 static gboolean
 gst_zmq_src_stop (GstBaseSrc * bsrc)
 {
@@ -301,57 +1242,296 @@ gst_zmq_src_stop (GstBaseSrc * bsrc)
 }
 
 static gboolean
-gst_zmq_src_open (GstZmqSrc * src)
+gst_zmq_src_set_int_option (GstZmqSrc * src, void *socket, int option,
+    int value)
 {
+  int rc = zmq_setsockopt (socket, option, &value, sizeof (value));
 
-  gboolean retval = TRUE;
+  if (rc) {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS,
+        ("zmq_setsockopt() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* catch the endpoint and socket type combinations libzmq would only
+ * reject with an unhelpful errno; like gst_zmq_src_attach(), an error when
+ * opening, but only a warning for a change while streaming */
+static gboolean
+gst_zmq_src_check_transport (GstZmqSrc * src, const gchar * endpoint,
+    gboolean live)
+{
+  gchar *message = NULL;
+  gboolean ok;
+
+#ifdef HAVE_ZMQ_HAS
+  if (gst_zmq_endpoint_is_multicast (endpoint) && !zmq_has ("pgm"))
+    message = g_strdup_printf ("endpoint \"%s\" needs a libzmq built with "
+        "PGM support", endpoint);
+#endif
+
+  if (!message && src->stripes > 1
+      && gst_zmq_endpoint_has_wildcard_port (endpoint))
+    message = g_strdup_printf ("endpoint \"%s\" cannot be striped: "
+        "stripe n uses the port n above the endpoint's, and a wildcard port "
+        "has no number to count from", endpoint);
+
+  if (!message && src->socket_type == GST_ZMQ_SRC_SOCKET_TYPE_DISH) {
+    if (!g_str_has_prefix (endpoint, "udp://"))
+      message = g_strdup_printf ("DISH sockets need a udp:// endpoint, "
+          "not \"%s\"", endpoint);
+    else if (strlen (src->group) == 0 || strlen (src->group) > 15)
+      message = g_strdup_printf ("group \"%s\" must be 1 to 15 characters",
+          src->group);
+    else if (src->stripes > 1)
+      message = g_strdup ("DISH sockets cannot be striped");
+  }
+
+  if (message && live)
+    GST_ELEMENT_WARNING (src, RESOURCE, SETTINGS, ("%s", message), NULL);
+  else if (message)
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, ("%s", message), NULL);
+
+  ok = message == NULL;
+  g_free (message);
+
+  return ok;
+}
+
+static gboolean
+gst_zmq_src_set_connection_options (GstZmqSrc * src, void *socket)
+{
+  if (!gst_zmq_src_set_int_option (src, socket, ZMQ_RECONNECT_IVL,
+          src->reconnect_ivl)
+      || !gst_zmq_src_set_int_option (src, socket, ZMQ_RECONNECT_IVL_MAX,
+          src->reconnect_ivl_max))
+    return FALSE;
+
+#ifdef ZMQ_HEARTBEAT_IVL
+  if (!gst_zmq_src_set_int_option (src, socket, ZMQ_HEARTBEAT_IVL,
+          src->heartbeat_ivl)
+      || !gst_zmq_src_set_int_option (src, socket, ZMQ_HEARTBEAT_TIMEOUT,
+          src->heartbeat_timeout ? src->heartbeat_timeout :
+          src->heartbeat_ivl)
+      || !gst_zmq_src_set_int_option (src, socket, ZMQ_HEARTBEAT_TTL,
+          src->heartbeat_ttl))
+    return FALSE;
+#endif
+
+  /* a subscriber has nothing worth delivering when it closes */
+  return gst_zmq_src_set_int_option (src, socket, ZMQ_LINGER, 0);
+}
+
+/* binds or connects the socket of @stripe to @endpoint; failing is an
+ * error when opening, but only a warning for a change while streaming */
+static gboolean
+gst_zmq_src_attach (GstZmqSrc * src, guint stripe, const gchar * endpoint,
+    gboolean bind, gboolean live)
+{
+  void *socket = src->sockets[stripe];
+  gchar *address = gst_zmq_stripe_endpoint (endpoint, stripe);
+  gchar *message = NULL;
+  int rc = 0;
+
+  if (gst_zmq_endpoint_is_multicast (address)) {
+    rc = zmq_setsockopt (socket, ZMQ_RATE, &src->multicast_rate,
+        sizeof (src->multicast_rate));
+    if (rc)
+      message = g_strdup_printf ("zmq_setsockopt() failed with error code "
+          "%d [%s]", errno, zmq_strerror (errno));
+  }
+
+  if (rc == 0) {
+    GST_DEBUG_OBJECT (src, "%s endpoint %s", bind ? "binding to" :
+        "connecting to", address);
+    rc = bind ? zmq_bind (socket, address) : zmq_connect (socket, address);
+    if (rc)
+      message = g_strdup_printf ("%s to endpoint \"%s\" failed with error "
+          "code %d [%s]", bind ? "zmq_bind()" : "zmq_connect()", address,
+          errno, zmq_strerror (errno));
+  }
+
+  /* libzmq only unbinds a wildcard such as tcp://*:5556 by the address it
+   * resolved to, so remember that */
+  if (rc == 0) {
+    gchar resolved[256];
+    size_t size = sizeof (resolved);
+
+    if (bind && zmq_getsockopt (socket, ZMQ_LAST_ENDPOINT, resolved,
+            &size) == 0)
+      g_hash_table_insert (src->attached,
+          g_strdup_printf ("%u %s", stripe, address), g_strdup (resolved));
+    else
+      g_hash_table_insert (src->attached,
+          g_strdup_printf ("%u %s", stripe, address), g_strdup (address));
+  }
+
+  if (message && live)
+    GST_ELEMENT_WARNING (src, RESOURCE, OPEN_READ_WRITE, ("%s", message),
+        NULL);
+  else if (message)
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE, ("%s", message), NULL);
+
+  g_free (message);
+  g_free (address);
 
+  return rc == 0;
+}
+
+/* undoes gst_zmq_src_attach(); returns FALSE if the endpoint is still
+ * attached */
+static gboolean
+gst_zmq_src_detach (GstZmqSrc * src, guint stripe, const gchar * endpoint,
+    gboolean bind)
+{
+  void *socket = src->sockets[stripe];
+  gchar *address = gst_zmq_stripe_endpoint (endpoint, stripe);
+  gchar *key = g_strdup_printf ("%u %s", stripe, address);
+  const gchar *target = g_hash_table_lookup (src->attached, key);
+  int rc = 0;
+
+  if (target) {
+    GST_DEBUG_OBJECT (src, "%s endpoint %s", bind ? "unbinding from" :
+        "disconnecting from", target);
+    rc = bind ? zmq_unbind (socket, target) : zmq_disconnect (socket, target);
+    if (rc)
+      GST_ELEMENT_WARNING (src, RESOURCE, CLOSE,
+          ("%s from endpoint \"%s\" failed with error code %d [%s]",
+              bind ? "zmq_unbind()" : "zmq_disconnect()", target, errno,
+              zmq_strerror (errno)), NULL);
+    else
+      g_hash_table_remove (src->attached, key);
+  }
+
+  g_free (key);
+  g_free (address);
+
+  return rc == 0;
+}
+
+/* brings the sockets up to date with the endpoint and bind properties,
+ * leaving the endpoints that stay alone, so their peers do not notice;
+ * an endpoint that cannot be added is reported and left out, one that
+ * cannot be removed is reported and kept for the next change */
+static void
+gst_zmq_src_apply_endpoints (GstZmqSrc * src)
+{
+  GPtrArray *applied = g_ptr_array_new ();
+  gchar **endpoints;
+  gboolean bind, rebind, ok;
+  guint i, stripe;
+
+  g_atomic_int_set (&src->reconfigure, FALSE);
+
+  GST_OBJECT_LOCK (src);
+  endpoints = gst_zmq_endpoints_parse (src->endpoint);
+  bind = src->bind;
+  GST_OBJECT_UNLOCK (src);
+
+  /* switching between binding and connecting redoes every endpoint */
+  rebind = bind != src->bound;
+
+  for (i = 0; src->endpoints[i]; i++) {
+    if (!rebind && gst_zmq_endpoints_contain (endpoints, src->endpoints[i]))
+      continue;
+    GST_INFO_OBJECT (src, "removing endpoint %s", src->endpoints[i]);
+    ok = TRUE;
+    for (stripe = 0; stripe < src->n_sockets; stripe++)
+      ok = gst_zmq_src_detach (src, stripe, src->endpoints[i],
+          src->bound) && ok;
+    /* after a rebind it would be detached the wrong way next time */
+    if (!ok && !rebind)
+      g_ptr_array_add (applied, g_strdup (src->endpoints[i]));
+  }
+
+  for (i = 0; endpoints[i]; i++) {
+    ok = TRUE;
+    if (rebind || !gst_zmq_endpoints_contain (src->endpoints, endpoints[i])) {
+      GST_INFO_OBJECT (src, "adding endpoint %s", endpoints[i]);
+      ok = gst_zmq_src_check_transport (src, endpoints[i], TRUE);
+      for (stripe = 0; ok && stripe < src->n_sockets; stripe++)
+        ok = gst_zmq_src_attach (src, stripe, endpoints[i], bind, TRUE);
+      /* a stream is striped over all of the sockets or none */
+      while (!ok && stripe-- > 1)
+        gst_zmq_src_detach (src, stripe - 1, endpoints[i], bind);
+    }
+    if (ok)
+      g_ptr_array_add (applied, g_strdup (endpoints[i]));
+  }
+  g_ptr_array_add (applied, NULL);
+
+  g_strfreev (endpoints);
+  g_strfreev (src->endpoints);
+  src->endpoints = (gchar **) g_ptr_array_free (applied, FALSE);
+  src->bound = bind;
+}
+
+/* creates, configures and binds or connects the socket of one stripe */
+static gboolean
+gst_zmq_src_open_socket (GstZmqSrc * src, guint stripe)
+{
+  gboolean retval = TRUE;
+  void *socket;
+  guint i;
   int rc;
 
-  src->socket = zmq_socket (src->context, ZMQ_SUB);
-  if (!src->socket) {
+#ifdef HAVE_ZMQ_RADIO_DISH
+  if (src->socket_type == GST_ZMQ_SRC_SOCKET_TYPE_DISH)
+    socket = zmq_socket (src->context, ZMQ_DISH);
+  else
+#endif
+    socket = zmq_socket (src->context, ZMQ_SUB);
+  if (!socket) {
     GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
         ("zmq_socket() failed with error code %d [%s]", errno,
             zmq_strerror (errno)), NULL);
-    retval = FALSE;
+    return FALSE;
   }
+  src->sockets[src->n_sockets++] = socket;
 
-  if (retval) {
-    if (src->bind) {
-      GST_DEBUG ("binding to endpoint %s", src->endpoint);
-      rc = zmq_bind (src->socket, src->endpoint);
-      if (rc) {
-        GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
-            ("zmq_bind() to endpoint \"%s\" failed with error code %d [%s]",
-                src->endpoint, errno, zmq_strerror (errno)), NULL);
-        retval = FALSE;
-      }
-    } else {
-      GST_DEBUG ("connecting to endpoint %s", src->endpoint);
-      rc = zmq_connect (src->socket, src->endpoint);
-      if (rc) {
-        GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
-            ("zmq_connect() to endpoint \"%s\" failed with error code %d [%s]",
-                src->endpoint, errno, zmq_strerror (errno)), NULL);
-        retval = FALSE;
-      }
-    }
-  }
+  retval = gst_zmq_src_set_connection_options (src, socket);
 
-  if (retval) {
-    rc = zmq_setsockopt (src->socket, ZMQ_SUBSCRIBE, "", 0);
+  if (retval && src->stripes > 1) {
+    /* receive each stripe on an I/O thread of its own */
+    guint64 affinity = G_GUINT64_CONSTANT (1) << stripe;
+    rc = zmq_setsockopt (socket, ZMQ_AFFINITY, &affinity, sizeof (affinity));
     if (rc) {
-      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
+      GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS,
           ("zmq_setsockopt() failed with error code %d [%s]", errno,
               zmq_strerror (errno)), NULL);
       retval = FALSE;
     }
   }
 
+  /* watch the socket before binding or connecting, so the first listening
+   * or connect events are seen too */
+  if (retval && src->socket_monitor
+      && !gst_zmq_monitor_add_socket (src->socket_monitor, socket)) {
+    gst_zmq_monitor_free (src->socket_monitor);
+    src->socket_monitor = NULL;
+  }
+
+  for (i = 0; retval && src->endpoints[i]; i++)
+    retval = gst_zmq_src_check_transport (src, src->endpoints[i], FALSE)
+        && gst_zmq_src_attach (src, stripe, src->endpoints[i], src->bound,
+        FALSE);
+
+#ifdef HAVE_ZMQ_RADIO_DISH
+  if (retval && src->socket_type == GST_ZMQ_SRC_SOCKET_TYPE_DISH) {
+    rc = zmq_join (socket, src->group);
+    if (rc) {
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
+          ("zmq_join() of group \"%s\" failed with error code %d [%s]",
+              src->group, errno, zmq_strerror (errno)), NULL);
+      retval = FALSE;
+    }
+  } else
+#endif
   if (retval) {
-    int timeout_ms = 1000;
-    rc = zmq_setsockopt (src->socket, ZMQ_RCVTIMEO, &timeout_ms,
-        sizeof (timeout_ms));
+    rc = zmq_setsockopt (socket, ZMQ_SUBSCRIBE, "", 0);
     if (rc) {
       GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
           ("zmq_setsockopt() failed with error code %d [%s]", errno,
@@ -363,21 +1543,179 @@ gst_zmq_src_open (GstZmqSrc * src)
   return retval;
 }
 
+/* an inproc pipe whose far end unlock() writes to, so the streaming thread
+ * does not sit out the receive timeout when asked to stop */
+static gboolean
+gst_zmq_src_open_wakeup (GstZmqSrc * src)
+{
+  void *wakeup_recv = NULL, *wakeup_send = NULL;
+  gchar *endpoint;
+  int linger = 0;
+
+  endpoint = g_strdup_printf ("inproc://gstzmqsrc-wakeup-%p", src);
+
+  wakeup_recv = zmq_socket (src->context, ZMQ_PAIR);
+  if (wakeup_recv)
+    wakeup_send = zmq_socket (src->context, ZMQ_PAIR);
+  if (!wakeup_send) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_socket() of wakeup pipe failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    goto fail;
+  }
+
+  /* nothing sent on the pipe is worth waiting for on close */
+  if (zmq_setsockopt (wakeup_recv, ZMQ_LINGER, &linger, sizeof (linger))
+      || zmq_setsockopt (wakeup_send, ZMQ_LINGER, &linger, sizeof (linger))) {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS,
+        ("zmq_setsockopt() of wakeup pipe failed with error code %d [%s]",
+            errno, zmq_strerror (errno)), NULL);
+    goto fail;
+  }
+
+  if (zmq_bind (wakeup_recv, endpoint)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_bind() of wakeup pipe failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    goto fail;
+  }
+
+  if (zmq_connect (wakeup_send, endpoint)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE,
+        ("zmq_connect() of wakeup pipe failed with error code %d [%s]",
+            errno, zmq_strerror (errno)), NULL);
+    goto fail;
+  }
+  g_free (endpoint);
+
+  GST_OBJECT_LOCK (src);
+  src->wakeup_recv = wakeup_recv;
+  src->wakeup_send = wakeup_send;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+
+fail:
+  if (wakeup_send)
+    zmq_close (wakeup_send);
+  if (wakeup_recv)
+    zmq_close (wakeup_recv);
+  g_free (endpoint);
+  return FALSE;
+}
+
 static gboolean
 gst_zmq_src_close (GstZmqSrc * src)
 {
 
   gboolean retval = TRUE;
+  guint i;
 
-  int rc = zmq_close (src->socket);
+  gst_zmq_monitor_free (src->socket_monitor);
+  src->socket_monitor = NULL;
 
-  if (rc) {
-    GST_ELEMENT_WARNING (src, RESOURCE, CLOSE,
-        ("zmq_close() failed with error code %d [%s]", errno, strerror (errno)),
-        NULL);
+  gst_zmq_reassembly_clear (&src->reassembly);
+
+  for (i = 0; i < src->n_sockets; i++) {
+    int rc = zmq_close (src->sockets[i]);
+
+    if (rc) {
+      GST_ELEMENT_WARNING (src, RESOURCE, CLOSE,
+          ("zmq_close() failed with error code %d [%s]", errno,
+              strerror (errno)), NULL);
+      retval = FALSE;
+    }
+  }
+  src->n_sockets = 0;
+
+  g_strfreev (src->endpoints);
+  src->endpoints = NULL;
+  if (src->attached) {
+    g_hash_table_destroy (src->attached);
+    src->attached = NULL;
+  }
+
+  GST_OBJECT_LOCK (src);
+  if (src->wakeup_send) {
+    zmq_close (src->wakeup_send);
+    zmq_close (src->wakeup_recv);
+    src->wakeup_send = src->wakeup_recv = NULL;
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  /* every socket of the context is closed by now, so this does not block */
+  if (src->context) {
+    zmq_ctx_destroy (src->context);
+    src->context = NULL;
+  }
+
+  return retval;
+}
+
+static gboolean
+gst_zmq_src_open (GstZmqSrc * src)
+{
+
+  gboolean retval = TRUE;
+  guint i;
+
+  gst_zmq_stats_reset (&src->stats);
+  src->have_seqnum = FALSE;
+  src->last_message_time = GST_CLOCK_TIME_NONE;
+  src->stalled = FALSE;
+  src->last_stripe = 0;
+  src->flushing = FALSE;
+  gst_zmq_reassembly_init (&src->reassembly, gst_zmq_src_alloc_buffer,
+      gst_zmq_src_decode, src, src->stripes > 1 ? src->stripes : 0,
+      ZMQ_DEFAULT_MAX_PAYLOAD_SIZE, &src->stats.reassembly_drops);
+
+  /* a context of its own each time, as libzmq only honours the number
+   * of I/O threads, one per stripe, before the first socket is created */
+  src->context = zmq_ctx_new ();
+  if (!src->context) {
+    GST_ELEMENT_ERROR (src, RESOURCE, FAILED,
+        ("zmq_ctx_new() failed with error code %d [%s]", errno,
+            zmq_strerror (errno)), NULL);
+    return FALSE;
+  }
+  if (src->stripes > 1)
+    zmq_ctx_set (src->context, ZMQ_IO_THREADS, src->stripes);
+
+  /* changes from here on are applied by the streaming thread */
+  g_atomic_int_set (&src->reconfigure, FALSE);
+  GST_OBJECT_LOCK (src);
+  src->endpoints = gst_zmq_endpoints_parse (src->endpoint);
+  src->bound = src->bind;
+  GST_OBJECT_UNLOCK (src);
+  src->attached = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+
+  src->receive_timeout = ZMQ_RECEIVE_TIMEOUT_MS;
+
+  if (src->monitor)
+    src->socket_monitor = gst_zmq_monitor_new (GST_ELEMENT (src),
+        src->context, &src->stats);
+
+  if (!src->endpoints[0]) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+        ("no endpoint to receive from"), NULL);
     retval = FALSE;
   }
 
+  if (retval)
+    retval = gst_zmq_src_open_wakeup (src);
+
+  for (i = 0; i < src->stripes && retval; i++)
+    retval = gst_zmq_src_open_socket (src, i);
+
+  if (src->socket_monitor && !gst_zmq_monitor_start (src->socket_monitor)) {
+    gst_zmq_monitor_free (src->socket_monitor);
+    src->socket_monitor = NULL;
+  }
+
+  if (!retval)
+    gst_zmq_src_close (src);
+
   return retval;
 }
 
@@ -26,6 +26,12 @@
 #include <gst/gst.h>
 #include <gst/base/gstpushsrc.h>
 
+#include "gstzmq.h"
+#include "gstzmqframing.h"
+#include "gstzmqmonitor.h"
+#include "gstzmqstats.h"
+#include "gstzmqtracer.h"
+
 //#include <gio/gio.h>
 
 G_BEGIN_DECLS
@@ -44,6 +50,11 @@ G_BEGIN_DECLS
 typedef struct _GstZmqSrc GstZmqSrc;
 typedef struct _GstZmqSrcClass GstZmqSrcClass;
 
+typedef enum {
+  GST_ZMQ_SRC_SOCKET_TYPE_SUB,
+  GST_ZMQ_SRC_SOCKET_TYPE_DISH
+} GstZmqSrcSocketType;
+
 typedef enum {
   GST_ZMQ_SRC_OPEN       = (GST_BASE_SRC_FLAG_LAST << 0),
 
@@ -56,10 +67,60 @@ struct _GstZmqSrc {
   // properties
   gchar *endpoint;
   gboolean bind;
+  GstZmqSrcSocketType socket_type;
+  gchar *group;
+  gint multicast_rate;
+  guint stripes;
+  guint max_message_size;
+  gint64 clock_offset;
+  gboolean monitor;
+  gint reconnect_ivl;
+  gint reconnect_ivl_max;
+  gint heartbeat_ivl;
+  gint heartbeat_timeout;
+  gint heartbeat_ttl;
+  guint stall_timeout;
+  gboolean eos_on_stall;
+
+  // allocation
+  guint learned_size;
+  guint pool_size;
+  GstFlowReturn alloc_ret;      // why the pool last refused a buffer
+
+  // framing
+  guint64 last_seqnum;
+  guint32 last_sender;
+  gboolean have_seqnum;
+  GstZmqReassembly reassembly;
+
+  // stall detection
+  GstClockTime last_message_time;
+  gboolean stalled;
   
+  GstZmqStats stats;
+  GstZmqSrcTiming timing;
+
   // zmq stuff
   void *context;
-  void *socket;
+  void *sockets[ZMQ_MAX_STRIPES];
+  guint n_sockets;
+  guint last_stripe;
+  int receive_timeout;
+
+  // what the sockets are bound or connected to; only the streaming thread
+  // touches the sockets, so set_property() asks it to catch up
+  gchar **endpoints;
+  gboolean bound;
+  gint reconfigure;
+  // "<stripe> <address>" to what that stripe's socket has to unbind or
+  // disconnect, which for a wildcard bind is the address it resolved to
+  GHashTable *attached;
+
+  // lets unlock() interrupt a receive from another thread
+  void *wakeup_send;
+  void *wakeup_recv;
+  gint flushing;
+  GstZmqMonitor *socket_monitor;
   
   //GCancellable *cancellable;
 };
@@ -0,0 +1,171 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>               // for ldexp
+#include <string.h>             // for memset
+
+#include "gstzmqstats.h"
+
+static inline guint
+gst_zmq_histogram_bucket (guint64 value)
+{
+  return value ? 64 - __builtin_clzll (value) : 0;
+}
+
+void
+gst_zmq_histogram_add (GstZmqHistogram * hist, guint64 value)
+{
+  GST_ZMQ_STAT_INC (hist->buckets[gst_zmq_histogram_bucket (value)]);
+  GST_ZMQ_STAT_INC (hist->count);
+  if (value > GST_ZMQ_STAT_GET (hist->max))
+    __atomic_store_n (&hist->max, value, __ATOMIC_RELAXED);
+}
+
+/* estimated by interpolating linearly inside the bucket the percentile
+ * falls into */
+guint64
+gst_zmq_histogram_percentile (GstZmqHistogram * hist, guint percent)
+{
+  guint64 count, rank, seen = 0, n, max;
+  gdouble lo, hi;
+  guint i;
+
+  count = GST_ZMQ_STAT_GET (hist->count);
+  max = GST_ZMQ_STAT_GET (hist->max);
+  if (count == 0)
+    return 0;
+
+  rank = MAX ((count * percent + 99) / 100, 1);
+
+  for (i = 0; i < GST_ZMQ_HISTOGRAM_BUCKETS; i++) {
+    n = GST_ZMQ_STAT_GET (hist->buckets[i]);
+    if (n && seen + n >= rank) {
+      if (i == 0)
+        return 0;
+      lo = ldexp (1.0, i - 1);
+      hi = ldexp (1.0, i);
+      return MIN ((guint64) (lo + (hi - lo) * (rank - seen) / n), max);
+    }
+    seen += n;
+  }
+
+  return max;
+}
+
+void
+gst_zmq_histogram_to_structure (GstZmqHistogram * hist, GstStructure * s,
+    const gchar * field)
+{
+  GValue array = G_VALUE_INIT;
+  GValue bucket = G_VALUE_INIT;
+  gint i, last = -1;
+
+  for (i = 0; i < GST_ZMQ_HISTOGRAM_BUCKETS; i++) {
+    if (GST_ZMQ_STAT_GET (hist->buckets[i]))
+      last = i;
+  }
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&bucket, G_TYPE_UINT64);
+  for (i = 0; i <= last; i++) {
+    g_value_set_uint64 (&bucket, GST_ZMQ_STAT_GET (hist->buckets[i]));
+    gst_value_array_append_value (&array, &bucket);
+  }
+  g_value_unset (&bucket);
+
+  gst_structure_take_value (s, field, &array);
+}
+
+void
+gst_zmq_stats_reset (GstZmqStats * stats)
+{
+  GstClockTime interval = stats->interval;
+
+  memset (stats, 0, sizeof (GstZmqStats));
+  stats->interval = interval;
+}
+
+void
+gst_zmq_stats_add_message (GstZmqStats * stats, gsize size,
+    GstClockTime blocked)
+{
+  GST_ZMQ_STAT_INC (stats->messages);
+  GST_ZMQ_STAT_ADD (stats->bytes, size);
+  GST_ZMQ_STAT_ADD (stats->blocked_time, blocked);
+  gst_zmq_histogram_add (&stats->sizes, size);
+}
+
+GstStructure *
+gst_zmq_stats_get_structure (GstZmqStats * stats, const gchar * name)
+{
+  GstStructure *s;
+
+  s = gst_structure_new (name,
+      "messages", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->messages),
+      "bytes", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->bytes),
+      "blocked-time", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->blocked_time),
+      "eagain", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->eagain),
+      "errors", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->errors),
+      "max-message-size", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->sizes.max),
+      "sequence-gaps", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->sequence_gaps),
+      "disconnects", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->disconnects),
+      "reconnects", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->reconnects),
+      "reassembly-drops", G_TYPE_UINT64,
+      GST_ZMQ_STAT_GET (stats->reassembly_drops),
+      "compressed", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->compressed),
+      "compression-bypassed", G_TYPE_UINT64,
+      GST_ZMQ_STAT_GET (stats->compression_bypassed),
+      "latency-p50", G_TYPE_UINT64,
+      gst_zmq_histogram_percentile (&stats->latency, 50),
+      "latency-p99", G_TYPE_UINT64,
+      gst_zmq_histogram_percentile (&stats->latency, 99),
+      "latency-max", G_TYPE_UINT64, GST_ZMQ_STAT_GET (stats->latency.max),
+      NULL);
+  gst_zmq_histogram_to_structure (&stats->sizes, s, "size-histogram");
+  gst_zmq_histogram_to_structure (&stats->latency, s, "latency-histogram");
+
+  return s;
+}
+
+void
+gst_zmq_stats_maybe_post (GstZmqStats * stats, GstElement * element,
+    const gchar * name, GstClockTime now)
+{
+  GstClockTime interval = GST_ZMQ_STAT_GET (stats->interval);
+
+  if (interval == 0)
+    return;
+
+  if (stats->last_post == 0) {
+    stats->last_post = now;
+    return;
+  }
+
+  if (now - stats->last_post < interval)
+    return;
+
+  stats->last_post = now;
+  gst_element_post_message (element,
+      gst_message_new_element (GST_OBJECT (element),
+          gst_zmq_stats_get_structure (stats, name)));
+}
@@ -0,0 +1,83 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_ZMQ_STATS_H__
+#define __GST_ZMQ_STATS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* counters are written by the streaming thread only and read from any
+ * thread, so relaxed atomics are all that is needed */
+#define GST_ZMQ_STAT_ADD(field, val) \
+  __atomic_fetch_add (&(field), (guint64) (val), __ATOMIC_RELAXED)
+#define GST_ZMQ_STAT_INC(field) GST_ZMQ_STAT_ADD (field, 1)
+#define GST_ZMQ_STAT_GET(field) \
+  __atomic_load_n (&(field), __ATOMIC_RELAXED)
+
+/* bucket 0 counts zeroes, bucket n counts values in [2^(n-1), 2^n) */
+#define GST_ZMQ_HISTOGRAM_BUCKETS 65
+
+typedef struct _GstZmqHistogram GstZmqHistogram;
+typedef struct _GstZmqStats GstZmqStats;
+
+struct _GstZmqHistogram {
+  guint64 count;
+  guint64 max;
+  guint64 buckets[GST_ZMQ_HISTOGRAM_BUCKETS];
+};
+
+struct _GstZmqStats {
+  guint64 messages;
+  guint64 bytes;
+  guint64 blocked_time;         // ns spent inside zmq_msg_send/recv
+  guint64 eagain;               // receive timeouts, zmqsrc only
+  guint64 errors;
+  guint64 sequence_gaps;        // messages missing between stamped ones
+  guint64 disconnects;          // written by the monitor thread
+  guint64 reconnects;
+  guint64 reassembly_drops;     // fragmented payloads never completed
+  guint64 compressed;           // payloads sent or received compressed
+  guint64 compression_bypassed; // payloads sent as is to save effort
+  GstZmqHistogram sizes;
+  GstZmqHistogram latency;      // ns, only for stamped messages
+
+  // periodic element message, 0 = disabled
+  GstClockTime interval;
+  GstClockTime last_post;
+};
+
+void gst_zmq_histogram_add (GstZmqHistogram * hist, guint64 value);
+guint64 gst_zmq_histogram_percentile (GstZmqHistogram * hist, guint percent);
+void gst_zmq_histogram_to_structure (GstZmqHistogram * hist,
+    GstStructure * s, const gchar * field);
+
+void gst_zmq_stats_reset (GstZmqStats * stats);
+void gst_zmq_stats_add_message (GstZmqStats * stats, gsize size,
+    GstClockTime blocked);
+GstStructure *gst_zmq_stats_get_structure (GstZmqStats * stats,
+    const gchar * name);
+void gst_zmq_stats_maybe_post (GstZmqStats * stats, GstElement * element,
+    const gchar * name, GstClockTime now);
+
+G_END_DECLS
+
+#endif /* __GST_ZMQ_STATS_H__ */
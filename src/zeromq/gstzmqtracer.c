@@ -0,0 +1,182 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:tracer-zmqstats
+ *
+ * Logs where zmqsink and zmqsrc spend the time of each buffer: mapping,
+ * compressing, copying and sending in zmqsink, waiting, receiving and
+ * filling buffers in zmqsrc, along with message counts and backlogs.
+ *
+ * |[
+ * GST_TRACERS=zmqstats GST_DEBUG=GST_TRACER:7 gst-launch-1.0 zmqsrc ! fakesink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstzmqtracer.h"
+
+gint gst_zmq_tracers = 0;
+
+#if GST_CHECK_VERSION(1,8,0)
+
+#define GST_TYPE_ZMQ_STATS_TRACER (gst_zmq_stats_tracer_get_type ())
+
+typedef struct _GstZmqStatsTracer GstZmqStatsTracer;
+typedef struct _GstZmqStatsTracerClass GstZmqStatsTracerClass;
+
+struct _GstZmqStatsTracer {
+  GstTracer parent;
+};
+
+struct _GstZmqStatsTracerClass {
+  GstTracerClass parent_class;
+};
+
+static GType gst_zmq_stats_tracer_get_type (void);
+
+G_DEFINE_TYPE (GstZmqStatsTracer, gst_zmq_stats_tracer, GST_TYPE_TRACER);
+
+static GstTracerRecord *tr_render;
+static GstTracerRecord *tr_create;
+
+static GstStructure *
+gst_zmq_tracer_value (GType type, const gchar * description)
+{
+  return gst_structure_new ("value",
+      "type", G_TYPE_GTYPE, type,
+      "description", G_TYPE_STRING, description, NULL);
+}
+
+static GstStructure *
+gst_zmq_tracer_scope (GType type, GstTracerValueScope scope)
+{
+  return gst_structure_new ("scope",
+      "type", G_TYPE_GTYPE, type,
+      "related-to", GST_TYPE_TRACER_VALUE_SCOPE, scope, NULL);
+}
+
+static void
+gst_zmq_stats_tracer_finalize (GObject * object)
+{
+  g_atomic_int_add (&gst_zmq_tracers, -1);
+
+  G_OBJECT_CLASS (gst_zmq_stats_tracer_parent_class)->finalize (object);
+}
+
+static void
+gst_zmq_stats_tracer_class_init (GstZmqStatsTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gst_zmq_stats_tracer_finalize;
+
+  tr_render = gst_tracer_record_new ("zmqsink-render.class",
+      "thread-id", gst_zmq_tracer_scope (G_TYPE_UINT64,
+          GST_TRACER_VALUE_SCOPE_THREAD),
+      "element", gst_zmq_tracer_scope (G_TYPE_STRING,
+          GST_TRACER_VALUE_SCOPE_ELEMENT),
+      "ts", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "time the buffer was done with, in ns"),
+      "map", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent mapping the buffer"),
+      "compress", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent compressing the payload"),
+      "copy", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent filling messages and headers"),
+      "send", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent inside zmq_msg_send()"),
+      "messages", gst_zmq_tracer_value (G_TYPE_UINT,
+          "ZeroMQ messages the buffer was sent as"),
+      "size", gst_zmq_tracer_value (G_TYPE_UINT64, "buffer size in bytes"),
+      NULL);
+
+  tr_create = gst_tracer_record_new ("zmqsrc-create.class",
+      "thread-id", gst_zmq_tracer_scope (G_TYPE_UINT64,
+          GST_TRACER_VALUE_SCOPE_THREAD),
+      "element", gst_zmq_tracer_scope (G_TYPE_STRING,
+          GST_TRACER_VALUE_SCOPE_ELEMENT),
+      "ts", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "time the buffer was complete, in ns"),
+      "wait", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent waiting for messages"),
+      "receive", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent inside zmq_recv() or zmq_msg_recv()"),
+      "alloc", gst_zmq_tracer_value (G_TYPE_UINT64,
+          "ns spent getting, mapping and filling the buffer"),
+      "messages", gst_zmq_tracer_value (G_TYPE_UINT,
+          "ZeroMQ messages the buffer was received from"),
+      "queued", gst_zmq_tracer_value (G_TYPE_UINT,
+          "of those, messages that were waiting already"),
+      "pending", gst_zmq_tracer_value (G_TYPE_UINT,
+          "fragmented payloads still being reassembled"),
+      "size", gst_zmq_tracer_value (G_TYPE_UINT64, "buffer size in bytes"),
+      NULL);
+
+#if GST_CHECK_VERSION(1,10,0)
+  GST_OBJECT_FLAG_SET (tr_render, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_create, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+#endif
+}
+
+static void
+gst_zmq_stats_tracer_init (GstZmqStatsTracer * self)
+{
+  /* no core hooks: the elements report to us while this is set */
+  g_atomic_int_inc (&gst_zmq_tracers);
+}
+
+#endif
+
+gboolean
+gst_zmq_tracer_register (GstPlugin * plugin)
+{
+#if GST_CHECK_VERSION(1,8,0)
+  return gst_tracer_register (plugin, "zmqstats", GST_TYPE_ZMQ_STATS_TRACER);
+#else
+  return TRUE;
+#endif
+}
+
+void
+gst_zmq_tracer_log_render (GstElement * sink, const GstZmqSinkTiming * timing,
+    gsize size)
+{
+#if GST_CHECK_VERSION(1,8,0)
+  gst_tracer_record_log (tr_render, (guint64) (guintptr) g_thread_self (),
+      GST_OBJECT_NAME (sink), gst_util_get_timestamp (), timing->map,
+      timing->compress, timing->copy, timing->send, timing->messages,
+      (guint64) size);
+#endif
+}
+
+void
+gst_zmq_tracer_log_create (GstElement * src, const GstZmqSrcTiming * timing,
+    gsize size, guint pending)
+{
+#if GST_CHECK_VERSION(1,8,0)
+  gst_tracer_record_log (tr_create, (guint64) (guintptr) g_thread_self (),
+      GST_OBJECT_NAME (src), gst_util_get_timestamp (), timing->wait,
+      timing->blocked - MIN (timing->wait, timing->blocked), timing->alloc,
+      timing->messages, timing->queued, pending, (guint64) size);
+#endif
+}
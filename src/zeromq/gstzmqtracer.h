@@ -0,0 +1,64 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_ZMQ_TRACER_H__
+#define __GST_ZMQ_TRACER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* number of live zmqstats tracers; the elements only take their timings
+ * while it is not 0, so tracing costs a load and a branch when off */
+extern gint gst_zmq_tracers;
+
+#define GST_ZMQ_TRACING() G_UNLIKELY (g_atomic_int_get (&gst_zmq_tracers))
+
+typedef struct _GstZmqSinkTiming GstZmqSinkTiming;
+typedef struct _GstZmqSrcTiming GstZmqSrcTiming;
+
+/* where one zmqsink render call spent its time, in ns */
+struct _GstZmqSinkTiming {
+  GstClockTime map;             // mapping the buffer
+  GstClockTime compress;
+  GstClockTime copy;            // filling messages and headers
+  GstClockTime send;            // inside zmq_msg_send()
+  guint messages;
+};
+
+/* where one zmqsrc create call spent its time, in ns */
+struct _GstZmqSrcTiming {
+  GstClockTime wait;            // waiting for a message to arrive
+  GstClockTime blocked;         // waiting plus inside zmq_recv()
+  GstClockTime alloc;           // getting, mapping and filling the buffer
+  guint messages;
+  guint queued;                 // messages that were waiting already
+};
+
+gboolean gst_zmq_tracer_register (GstPlugin * plugin);
+
+void gst_zmq_tracer_log_render (GstElement * sink,
+    const GstZmqSinkTiming * timing, gsize size);
+void gst_zmq_tracer_log_create (GstElement * src,
+    const GstZmqSrcTiming * timing, gsize size, guint pending);
+
+G_END_DECLS
+
+#endif /* __GST_ZMQ_TRACER_H__ */
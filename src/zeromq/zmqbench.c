@@ -0,0 +1,564 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* zmqbench: pushes buffers from appsrc through zmqsink and zmqsrc to
+ * appsink in the same process, over ipc:// and loopback tcp://, for a
+ * sweep of message sizes and push modes, and prints throughput, CPU cost
+ * and latency of each run as JSON on stdout.
+ *
+ * Run it from the build tree with "make bench", which points it at the
+ * freshly built plugin; pass options through BENCH_FLAGS. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <sys/resource.h>       // for getrusage
+#include <unistd.h>             // for getpid
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <zmq.h>
+
+#include "gstzmqmeta.h"
+
+#define BENCH_DEFAULT_TRANSPORTS "ipc,tcp"
+#define BENCH_DEFAULT_MODES "single,copy,batch"
+#define BENCH_DEFAULT_FRAMINGS "plain,stamped"
+#define BENCH_DEFAULT_MIN_SIZE 64
+#define BENCH_DEFAULT_MAX_SIZE (32 * 1024 * 1024)
+#define BENCH_DEFAULT_VOLUME 256
+#define BENCH_DEFAULT_PORT 5599
+
+/* messages per run, whatever the volume */
+#define BENCH_MIN_MESSAGES 8
+#define BENCH_MAX_MESSAGES 100000
+
+#define BENCH_BATCH_SIZE 16
+
+#define BENCH_CONNECT_TIMEOUT (5 * G_TIME_SPAN_SECOND)
+#define BENCH_IDLE_TIMEOUT (1 * G_TIME_SPAN_SECOND)
+#define BENCH_QUIET_TIME (100 * G_TIME_SPAN_MILLISECOND)
+
+typedef enum {
+  BENCH_MODE_SINGLE,
+  BENCH_MODE_COPY,
+  BENCH_MODE_BATCH
+} BenchMode;
+
+static const gchar *bench_mode_names[] = { "single", "copy", "batch" };
+
+/* plain payloads need no header, so zmqsink can send large ones without
+ * copying; stamped ones carry the send time, which latency is taken from */
+static const gchar *bench_framing_names[] = { "plain", "stamped" };
+
+typedef struct _Bench Bench;
+
+struct _Bench {
+  GstElement *sender;
+  GstElement *receiver;
+  GstElement *appsrc;
+  GstElement *zmqsink;
+
+  GMutex lock;
+  GCond cond;
+  guint64 received;
+  guint64 bytes;
+  gint64 last_time;
+  GArray *latencies;
+  GType meta_api;
+
+  gboolean first_result;
+};
+
+static gchar *opt_transports = NULL;
+static gchar *opt_modes = NULL;
+static gchar *opt_framings = NULL;
+static gint opt_min_size = BENCH_DEFAULT_MIN_SIZE;
+static gint opt_max_size = BENCH_DEFAULT_MAX_SIZE;
+static gint opt_volume = BENCH_DEFAULT_VOLUME;
+static gint opt_port = BENCH_DEFAULT_PORT;
+
+static GOptionEntry entries[] = {
+  {"transports", 't', 0, G_OPTION_ARG_STRING, &opt_transports,
+      "Comma separated transports to run over (default: "
+        BENCH_DEFAULT_TRANSPORTS ")", "LIST"},
+  {"modes", 'm', 0, G_OPTION_ARG_STRING, &opt_modes,
+        "Comma separated push modes: single pushes one buffer at a time, "
+        "copy pushes a fresh copy of the payload each time, batch pushes "
+        "buffer lists (default: " BENCH_DEFAULT_MODES ")", "LIST"},
+  {"framings", 'f', 0, G_OPTION_ARG_STRING, &opt_framings,
+        "Comma separated framings: plain sends payloads as they are, and "
+        "large ones without copying, stamped adds a header with the send "
+        "time to measure latency by (default: " BENCH_DEFAULT_FRAMINGS ")",
+      "LIST"},
+  {"min-size", 0, 0, G_OPTION_ARG_INT, &opt_min_size,
+      "Smallest message size in bytes", "BYTES"},
+  {"max-size", 0, 0, G_OPTION_ARG_INT, &opt_max_size,
+      "Largest message size in bytes", "BYTES"},
+  {"volume", 'V', 0, G_OPTION_ARG_INT, &opt_volume,
+      "MiB to send in each run", "MIB"},
+  {"port", 'p', 0, G_OPTION_ARG_INT, &opt_port,
+      "Loopback port for tcp runs", "PORT"},
+  {NULL}
+};
+
+static gint
+bench_compare_latency (gconstpointer a, gconstpointer b)
+{
+  gint64 la = *(const gint64 *) a, lb = *(const gint64 *) b;
+
+  return la < lb ? -1 : la > lb ? 1 : 0;
+}
+
+static gint64
+bench_percentile (GArray * sorted, guint percent)
+{
+  if (sorted->len == 0)
+    return -1;
+
+  return g_array_index (sorted, gint64, (sorted->len - 1) * percent / 100);
+}
+
+/* takes each buffer the way an application would, from appsink */
+static GstFlowReturn
+bench_new_sample (GstAppSink * appsink, gpointer user_data)
+{
+  Bench *bench = user_data;
+  GstSample *sample;
+  GstBuffer *buffer;
+  GstZmqMeta *meta = NULL;
+
+  sample = gst_app_sink_pull_sample (appsink);
+  if (!sample)
+    return GST_FLOW_FLUSHING;
+  buffer = gst_sample_get_buffer (sample);
+
+  g_mutex_lock (&bench->lock);
+
+  /* zmqsrc registers its meta with the first stamped message */
+  if (!bench->meta_api)
+    bench->meta_api = g_type_from_name ("GstZmqMetaAPI");
+  if (bench->meta_api)
+    meta = (GstZmqMeta *) gst_buffer_get_meta (buffer, bench->meta_api);
+
+  bench->received++;
+  bench->bytes += gst_buffer_get_size (buffer);
+  bench->last_time = g_get_monotonic_time ();
+  if (meta)
+    g_array_append_val (bench->latencies, meta->latency);
+
+  g_cond_signal (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+
+  gst_sample_unref (sample);
+
+  return GST_FLOW_OK;
+}
+
+static void
+bench_reset (Bench * bench)
+{
+  g_mutex_lock (&bench->lock);
+  bench->received = 0;
+  bench->bytes = 0;
+  bench->last_time = 0;
+  g_array_set_size (bench->latencies, 0);
+  g_mutex_unlock (&bench->lock);
+}
+
+/* waits until @expected messages arrived, or none arrived for @idle us,
+ * and returns how many arrived */
+static guint64
+bench_wait (Bench * bench, guint64 expected, gint64 idle)
+{
+  guint64 received;
+  gint64 deadline;
+
+  g_mutex_lock (&bench->lock);
+  deadline = g_get_monotonic_time () + idle;
+  while (bench->received < expected) {
+    received = bench->received;
+    if (!g_cond_wait_until (&bench->cond, &bench->lock, deadline)
+        && bench->received == received)
+      break;
+    if (bench->received != received)
+      deadline = g_get_monotonic_time () + idle;
+  }
+  received = bench->received;
+  g_mutex_unlock (&bench->lock);
+
+  return received;
+}
+
+static gboolean
+bench_check_bus (GstElement * pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+  GError *error = NULL;
+  gchar *debug = NULL;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  gst_object_unref (bus);
+  if (!msg)
+    return TRUE;
+
+  gst_message_parse_error (msg, &error, &debug);
+  g_printerr ("error from %s: %s\n%s\n", GST_OBJECT_NAME (msg->src),
+      error->message, debug ? debug : "");
+  g_clear_error (&error);
+  g_free (debug);
+  gst_message_unref (msg);
+
+  return FALSE;
+}
+
+static GstFlowReturn
+bench_push (Bench * bench, GstBuffer * payload, BenchMode mode, guint count)
+{
+  GstAppSrc *appsrc = GST_APP_SRC (bench->appsrc);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, j, n;
+
+  for (i = 0; i < count && ret == GST_FLOW_OK; i += n) {
+    n = 1;
+    switch (mode) {
+      case BENCH_MODE_SINGLE:
+        ret = gst_app_src_push_buffer (appsrc, gst_buffer_ref (payload));
+        break;
+      case BENCH_MODE_COPY:
+        ret = gst_app_src_push_buffer (appsrc, gst_buffer_copy_deep (payload));
+        break;
+      case BENCH_MODE_BATCH:{
+#if GST_CHECK_VERSION(1,14,0)
+        GstBufferList *list;
+
+        n = MIN (BENCH_BATCH_SIZE, count - i);
+        list = gst_buffer_list_new_sized (n);
+        for (j = 0; j < n; j++)
+          gst_buffer_list_add (list, gst_buffer_ref (payload));
+        ret = gst_app_src_push_buffer_list (appsrc, list);
+#else
+        (void) j;
+        ret = GST_FLOW_NOT_SUPPORTED;
+#endif
+        break;
+      }
+    }
+  }
+
+  return ret;
+}
+
+/* PUB drops what it sends before the subscription reached it, so keep
+ * sending until something arrives */
+static gboolean
+bench_connect (Bench * bench)
+{
+  GstBuffer *probe = gst_buffer_new_allocate (NULL, 64, NULL);
+  gint64 deadline = g_get_monotonic_time () + BENCH_CONNECT_TIMEOUT;
+  gboolean connected = FALSE;
+
+  gst_buffer_memset (probe, 0, 0, 64);
+
+  while (!connected && g_get_monotonic_time () < deadline) {
+    if (bench_push (bench, probe, BENCH_MODE_SINGLE, 1) != GST_FLOW_OK)
+      break;
+    connected = bench_wait (bench, 1, 10 * G_TIME_SPAN_MILLISECOND) > 0;
+  }
+  gst_buffer_unref (probe);
+
+  /* let the probes still in flight arrive */
+  bench_wait (bench, G_MAXUINT64, BENCH_QUIET_TIME);
+
+  return connected;
+}
+
+static gboolean
+bench_run (Bench * bench, const gchar * transport, guint size, BenchMode mode,
+    gboolean stamped)
+{
+  gchar *latency = NULL;
+  GstBuffer *payload;
+  GstFlowReturn ret;
+  struct rusage before, after;
+  guint64 received, bytes, cpu;
+  gint64 start, elapsed;
+  guint count;
+  gdouble seconds;
+
+  count = CLAMP ((guint64) opt_volume * 1024 * 1024 / size,
+      BENCH_MIN_MESSAGES, BENCH_MAX_MESSAGES);
+
+  payload = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_memset (payload, 0, 0x5a, size);
+
+  g_object_set (bench->appsrc, "max-bytes",
+      (guint64) MAX (4 * size, 4 * 1024 * 1024), NULL);
+  g_object_set (bench->zmqsink, "stamp", stamped, NULL);
+
+  bench_reset (bench);
+  getrusage (RUSAGE_SELF, &before);
+  start = g_get_monotonic_time ();
+
+  ret = bench_push (bench, payload, mode, count);
+  gst_buffer_unref (payload);
+  if (ret != GST_FLOW_OK) {
+    g_printerr ("%s: pushing %s %s buffers failed: %s\n", transport,
+        bench_framing_names[stamped], bench_mode_names[mode],
+        gst_flow_get_name (ret));
+    return ret == GST_FLOW_NOT_SUPPORTED;
+  }
+
+  received = bench_wait (bench, count, BENCH_IDLE_TIMEOUT);
+  getrusage (RUSAGE_SELF, &after);
+
+  g_mutex_lock (&bench->lock);
+  bytes = bench->bytes;
+  elapsed = MAX (bench->last_time - start, 1);
+  g_array_sort (bench->latencies, bench_compare_latency);
+  cpu = (after.ru_utime.tv_sec - before.ru_utime.tv_sec
+      + after.ru_stime.tv_sec - before.ru_stime.tv_sec) * GST_SECOND
+      + (after.ru_utime.tv_usec - before.ru_utime.tv_usec
+      + after.ru_stime.tv_usec - before.ru_stime.tv_usec) * GST_USECOND;
+  seconds = (gdouble) elapsed / G_TIME_SPAN_SECOND;
+
+  /* plain payloads carry no send time to measure latency by */
+  if (stamped)
+    latency = g_strdup_printf (", \"latency_p50_ns\": %" G_GINT64_FORMAT
+        ", \"latency_p99_ns\": %" G_GINT64_FORMAT,
+        bench_percentile (bench->latencies, 50),
+        bench_percentile (bench->latencies, 99));
+
+  g_print ("%s    {\"transport\": \"%s\", \"mode\": \"%s\", "
+      "\"framing\": \"%s\", \"size\": %u, "
+      "\"sent\": %u, \"received\": %" G_GUINT64_FORMAT ", "
+      "\"seconds\": %.6f, \"msgs_per_sec\": %.1f, \"gbytes_per_sec\": %.6f, "
+      "\"cpu_ns_per_byte\": %.6f%s}",
+      bench->first_result ? "" : ",\n", transport, bench_mode_names[mode],
+      bench_framing_names[stamped], size, count, received, seconds,
+      received / seconds, bytes / seconds / 1e9,
+      bytes ? (gdouble) cpu / bytes : 0.0, latency ? latency : "");
+  bench->first_result = FALSE;
+  g_mutex_unlock (&bench->lock);
+  g_free (latency);
+
+  g_printerr ("%s %s %s %u bytes: %" G_GUINT64_FORMAT "/%u messages in "
+      "%.3f s\n", transport, bench_framing_names[stamped],
+      bench_mode_names[mode], size, received, count, seconds);
+
+  /* stragglers of a lossy run must not count towards the next one */
+  bench_wait (bench, G_MAXUINT64, BENCH_QUIET_TIME);
+
+  return bench_check_bus (bench->sender) && bench_check_bus (bench->receiver);
+}
+
+static gboolean
+bench_transport (Bench * bench, const gchar * transport, gchar ** modes,
+    gchar ** framings)
+{
+  GstAppSinkCallbacks callbacks = { NULL, };
+  GstElement *appsink;
+  GError *error = NULL;
+  gchar *endpoint, *description;
+  gboolean ok = TRUE;
+  guint size, i, j, stamped;
+
+  if (g_str_equal (transport, "tcp")) {
+    endpoint = g_strdup_printf ("tcp://127.0.0.1:%d", opt_port);
+  } else if (g_str_equal (transport, "ipc")) {
+    endpoint = g_strdup_printf ("ipc://%s/gst-zmq-bench-%d",
+        g_get_tmp_dir (), (int) getpid ());
+  } else {
+    /* each element has a ZeroMQ context of its own, and inproc:// does
+     * not cross contexts */
+    g_printerr ("unsupported transport \"%s\"\n", transport);
+    return FALSE;
+  }
+
+  description = g_strdup_printf ("zmqsrc endpoint=%s bind=true ! "
+      "appsink name=appsink sync=false async=false",
+      endpoint);
+  bench->receiver = gst_parse_launch (description, &error);
+  g_free (description);
+
+  if (bench->receiver) {
+    description = g_strdup_printf ("appsrc name=appsrc block=true "
+        "format=bytes ! zmqsink name=zmqsink endpoint=%s bind=false "
+        "sync=false async=false", endpoint);
+    bench->sender = gst_parse_launch (description, &error);
+    g_free (description);
+  }
+  g_free (endpoint);
+
+  if (error) {
+    g_printerr ("could not create pipelines: %s\n", error->message);
+    g_clear_error (&error);
+    gst_object_replace ((GstObject **) & bench->receiver, NULL);
+    gst_object_replace ((GstObject **) & bench->sender, NULL);
+    return FALSE;
+  }
+
+  appsink = gst_bin_get_by_name (GST_BIN (bench->receiver), "appsink");
+  callbacks.new_sample = bench_new_sample;
+  gst_app_sink_set_callbacks (GST_APP_SINK (appsink), &callbacks, bench,
+      NULL);
+  gst_object_unref (appsink);
+  bench->appsrc = gst_bin_get_by_name (GST_BIN (bench->sender), "appsrc");
+  bench->zmqsink = gst_bin_get_by_name (GST_BIN (bench->sender), "zmqsink");
+
+  if (gst_element_set_state (bench->receiver, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE
+      || gst_element_set_state (bench->sender, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    bench_check_bus (bench->receiver);
+    bench_check_bus (bench->sender);
+    ok = FALSE;
+  } else if (!bench_connect (bench)) {
+    g_printerr ("%s: no message arrived within %" G_GINT64_FORMAT " s\n",
+        transport, BENCH_CONNECT_TIMEOUT / G_TIME_SPAN_SECOND);
+    ok = FALSE;
+  }
+
+  for (size = opt_min_size; ok && size <= (guint) opt_max_size;) {
+    for (i = 0; ok && modes[i]; i++) {
+      BenchMode mode;
+
+      for (mode = BENCH_MODE_SINGLE; mode <= BENCH_MODE_BATCH; mode++) {
+        if (g_str_equal (modes[i], bench_mode_names[mode]))
+          break;
+      }
+      if (mode > BENCH_MODE_BATCH) {
+        g_printerr ("unknown mode \"%s\"\n", modes[i]);
+        ok = FALSE;
+      }
+
+      for (j = 0; ok && framings[j]; j++) {
+        for (stamped = 0; stamped < G_N_ELEMENTS (bench_framing_names);
+            stamped++) {
+          if (g_str_equal (framings[j], bench_framing_names[stamped]))
+            break;
+        }
+        if (stamped == G_N_ELEMENTS (bench_framing_names)) {
+          g_printerr ("unknown framing \"%s\"\n", framings[j]);
+          ok = FALSE;
+        } else {
+          ok = bench_run (bench, transport, size, mode, stamped);
+        }
+      }
+    }
+
+    /* powers of 4, ending on the largest size */
+    if (size == (guint) opt_max_size)
+      break;
+    size = size > (guint) opt_max_size / 4 ? (guint) opt_max_size : size * 4;
+  }
+
+  gst_element_set_state (bench->sender, GST_STATE_NULL);
+  gst_element_set_state (bench->receiver, GST_STATE_NULL);
+  gst_object_unref (bench->appsrc);
+  gst_object_unref (bench->zmqsink);
+  gst_object_unref (bench->sender);
+  gst_object_unref (bench->receiver);
+  bench->appsrc = bench->zmqsink = bench->sender = bench->receiver = NULL;
+
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GstElementFactory *factory;
+  GError *error = NULL;
+  Bench bench = { NULL, };
+  gchar **transports, **modes, **framings;
+  gchar *version;
+  int major, minor, patch;
+  gboolean ok = TRUE;
+  guint i;
+
+  context = g_option_context_new ("- benchmark zmqsink to zmqsrc");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (opt_min_size <= 0 || opt_min_size > opt_max_size) {
+    g_printerr ("need 0 < min-size <= max-size\n");
+    return 1;
+  }
+  if (opt_volume <= 0) {
+    g_printerr ("need a volume of at least 1 MiB\n");
+    return 1;
+  }
+  if (opt_port <= 0 || opt_port > G_MAXUINT16) {
+    g_printerr ("need a port between 1 and %u\n", G_MAXUINT16);
+    return 1;
+  }
+
+  /* any version will do, the plugin is versioned with the tree, not with
+   * GStreamer */
+  factory = gst_element_factory_find ("zmqsink");
+  if (!factory) {
+    g_printerr ("the zmq plugin was not found, run \"make bench\" or set "
+        "GST_PLUGIN_PATH\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  g_mutex_init (&bench.lock);
+  g_cond_init (&bench.cond);
+  bench.latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+  bench.first_result = TRUE;
+
+  transports = g_strsplit (opt_transports ? opt_transports :
+      BENCH_DEFAULT_TRANSPORTS, ",", -1);
+  modes = g_strsplit (opt_modes ? opt_modes : BENCH_DEFAULT_MODES, ",", -1);
+  framings = g_strsplit (opt_framings ? opt_framings : BENCH_DEFAULT_FRAMINGS,
+      ",", -1);
+
+  version = gst_version_string ();
+  zmq_version (&major, &minor, &patch);
+  g_print ("{\n  \"gstreamer\": \"%s\",\n  \"zeromq\": \"%d.%d.%d\",\n"
+      "  \"results\": [\n", version, major, minor, patch);
+  g_free (version);
+
+  for (i = 0; ok && transports[i]; i++)
+    ok = bench_transport (&bench, transports[i], modes, framings);
+
+  g_print ("\n  ]\n}\n");
+
+  g_strfreev (transports);
+  g_strfreev (modes);
+  g_strfreev (framings);
+  g_array_free (bench.latencies, TRUE);
+  g_cond_clear (&bench.cond);
+  g_mutex_clear (&bench.lock);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,374 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>              // for O_CREAT and friends
+#include <stdio.h>
+#include <string.h>             // for memcpy
+#include <unistd.h>             // for close
+
+#include <glib/gstdio.h>
+
+#include "zmqcapture.h"
+
+#define CAPTURE_PAD(size) (((size) + 7) & ~(gsize) 7)
+
+struct _CaptureWriter {
+  gchar *path;
+  gchar *index_path;
+  FILE *file;
+  FILE *index;
+  guint64 offset;
+};
+
+struct _CaptureReader {
+  GMappedFile *file;
+  const guint8 *data;
+  gsize size;
+  GArray *offsets;              // of each record, as guint64
+};
+
+static void
+capture_put_u32 (guint8 * data, guint32 value)
+{
+  value = GUINT32_TO_BE (value);
+  memcpy (data, &value, sizeof (value));
+}
+
+static void
+capture_put_u64 (guint8 * data, guint64 value)
+{
+  value = GUINT64_TO_BE (value);
+  memcpy (data, &value, sizeof (value));
+}
+
+static guint32
+capture_get_u32 (const guint8 * data)
+{
+  guint32 value;
+
+  memcpy (&value, data, sizeof (value));
+  return GUINT32_FROM_BE (value);
+}
+
+static guint64
+capture_get_u64 (const guint8 * data)
+{
+  guint64 value;
+
+  memcpy (&value, data, sizeof (value));
+  return GUINT64_FROM_BE (value);
+}
+
+static void
+capture_set_errno_error (GError ** error, const gchar * path)
+{
+  int saved_errno = errno;
+
+  g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+      "%s: %s", path, g_strerror (saved_errno));
+}
+
+/* fopen() cannot refuse to replace an existing file, so open the
+ * descriptor first */
+static FILE *
+capture_open (const gchar * path, gboolean exclusive)
+{
+  FILE *file;
+  int fd, saved_errno;
+
+  fd = g_open (path, O_WRONLY | O_CREAT | (exclusive ? O_EXCL : O_TRUNC),
+      0666);
+  if (fd < 0)
+    return NULL;
+
+  file = fdopen (fd, "wb");
+  if (!file) {
+    saved_errno = errno;
+    close (fd);
+    errno = saved_errno;
+  }
+
+  return file;
+}
+
+/* an existing capture is only replaced when @overwrite is set; its index
+ * always is, it would describe some other capture's records */
+CaptureWriter *
+capture_writer_new (const gchar * path, gboolean overwrite, GError ** error)
+{
+  CaptureWriter *writer = g_slice_new0 (CaptureWriter);
+  guint8 header[CAPTURE_HEADER_SIZE] = { 0, };
+
+  writer->path = g_strdup (path);
+  writer->index_path = g_strconcat (path, CAPTURE_INDEX_SUFFIX, NULL);
+
+  writer->file = capture_open (writer->path, !overwrite);
+  if (!writer->file) {
+    capture_set_errno_error (error, writer->path);
+    capture_writer_close (writer, NULL);
+    return NULL;
+  }
+
+  writer->index = capture_open (writer->index_path, FALSE);
+  if (!writer->index) {
+    capture_set_errno_error (error, writer->index_path);
+    capture_writer_close (writer, NULL);
+    return NULL;
+  }
+
+  memcpy (header, CAPTURE_MAGIC, 8);
+  capture_put_u32 (header + 8, CAPTURE_VERSION);
+  capture_put_u32 (header + 12, CAPTURE_HEADER_SIZE);
+  capture_put_u64 (header + 16, g_get_real_time () * 1000);
+
+  if (fwrite (header, sizeof (header), 1, writer->file) != 1) {
+    capture_set_errno_error (error, writer->path);
+    capture_writer_close (writer, NULL);
+    return NULL;
+  }
+  writer->offset = sizeof (header);
+
+  return writer;
+}
+
+gboolean
+capture_writer_append (CaptureWriter * writer, guint64 time, guint32 flags,
+    const guint8 * data, gsize size, GError ** error)
+{
+  static const guint8 padding[8] = { 0, };
+  guint8 header[CAPTURE_RECORD_HEADER_SIZE];
+  guint8 entry[CAPTURE_INDEX_ENTRY_SIZE];
+
+  if (size > G_MAXUINT32) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FBIG,
+        "%s: cannot record a %" G_GSIZE_FORMAT " byte message", writer->path,
+        size);
+    return FALSE;
+  }
+
+  capture_put_u64 (header, time);
+  capture_put_u32 (header + 8, size);
+  capture_put_u32 (header + 12, flags);
+
+  if (fwrite (header, sizeof (header), 1, writer->file) != 1
+      || (size > 0 && fwrite (data, size, 1, writer->file) != 1)
+      || (CAPTURE_PAD (size) > size
+          && fwrite (padding, CAPTURE_PAD (size) - size, 1,
+              writer->file) != 1)) {
+    capture_set_errno_error (error, writer->path);
+    return FALSE;
+  }
+
+  capture_put_u64 (entry, writer->offset);
+  capture_put_u64 (entry + 8, time);
+
+  if (fwrite (entry, sizeof (entry), 1, writer->index) != 1) {
+    capture_set_errno_error (error, writer->index_path);
+    return FALSE;
+  }
+
+  writer->offset += sizeof (header) + CAPTURE_PAD (size);
+
+  return TRUE;
+}
+
+/* the capture goes out first, so the index never points past it */
+gboolean
+capture_writer_flush (CaptureWriter * writer, GError ** error)
+{
+  if (fflush (writer->file)) {
+    capture_set_errno_error (error, writer->path);
+    return FALSE;
+  }
+  if (fflush (writer->index)) {
+    capture_set_errno_error (error, writer->index_path);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+gboolean
+capture_writer_close (CaptureWriter * writer, GError ** error)
+{
+  gboolean ok = TRUE;
+
+  if (writer->file && writer->index)
+    ok = capture_writer_flush (writer, error);
+
+  if (writer->file && fclose (writer->file) && ok) {
+    capture_set_errno_error (error, writer->path);
+    ok = FALSE;
+  }
+  if (writer->index && fclose (writer->index) && ok) {
+    capture_set_errno_error (error, writer->index_path);
+    ok = FALSE;
+  }
+
+  g_free (writer->path);
+  g_free (writer->index_path);
+  g_slice_free (CaptureWriter, writer);
+
+  return ok;
+}
+
+/* returns the offset following the record at @offset, or 0 if the capture
+ * ends before the record does */
+static guint64
+capture_reader_record_end (CaptureReader * reader, guint64 offset)
+{
+  guint32 size;
+
+  if (offset + CAPTURE_RECORD_HEADER_SIZE > reader->size)
+    return 0;
+
+  size = capture_get_u32 (reader->data + offset + 8);
+  if (offset + CAPTURE_RECORD_HEADER_SIZE + size > reader->size)
+    return 0;
+
+  return offset + CAPTURE_RECORD_HEADER_SIZE + CAPTURE_PAD (size);
+}
+
+/* takes the records from the index for as long as each entry is where the
+ * previous record ends and the capture holds all of it, and returns the
+ * offset after the last one taken; an index that was cut short, or is
+ * stale or corrupt from some entry on, leaves the rest to scanning */
+static guint64
+capture_reader_load_index (CaptureReader * reader, const gchar * path,
+    guint64 offset)
+{
+  gchar *index_path = g_strconcat (path, CAPTURE_INDEX_SUFFIX, NULL);
+  GMappedFile *index = g_mapped_file_new (index_path, FALSE, NULL);
+  const guint8 *entries;
+  guint64 entry, end;
+  gsize n, i;
+
+  g_free (index_path);
+  if (!index)
+    return offset;
+
+  entries = (const guint8 *) g_mapped_file_get_contents (index);
+  n = g_mapped_file_get_length (index) / CAPTURE_INDEX_ENTRY_SIZE;
+
+  for (i = 0; i < n; i++) {
+    entry = capture_get_u64 (entries + i * CAPTURE_INDEX_ENTRY_SIZE);
+    if (entry != offset
+        || (end = capture_reader_record_end (reader, entry)) == 0)
+      break;
+    g_array_append_val (reader->offsets, entry);
+    offset = end;
+  }
+
+  g_mapped_file_unref (index);
+
+  return offset;
+}
+
+CaptureReader *
+capture_reader_new (const gchar * path, GError ** error)
+{
+  CaptureReader *reader;
+  GMappedFile *file;
+  guint64 offset, end;
+
+  file = g_mapped_file_new (path, FALSE, error);
+  if (!file)
+    return NULL;
+
+  reader = g_slice_new0 (CaptureReader);
+  reader->file = file;
+  reader->data = (const guint8 *) g_mapped_file_get_contents (file);
+  reader->size = g_mapped_file_get_length (file);
+  reader->offsets = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  if (reader->size < CAPTURE_HEADER_SIZE
+      || memcmp (reader->data, CAPTURE_MAGIC, 8) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s: not a capture file", path);
+    capture_reader_free (reader);
+    return NULL;
+  }
+
+  if (capture_get_u32 (reader->data + 8) != CAPTURE_VERSION) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s: unsupported capture version %u", path,
+        capture_get_u32 (reader->data + 8));
+    capture_reader_free (reader);
+    return NULL;
+  }
+
+  offset = capture_get_u32 (reader->data + 12);
+  if (offset < CAPTURE_HEADER_SIZE || offset > reader->size) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s: corrupt capture header", path);
+    capture_reader_free (reader);
+    return NULL;
+  }
+
+  /* whatever was recorded after the index was last written is found by
+   * reading through the rest of the capture */
+  offset = capture_reader_load_index (reader, path, offset);
+  while ((end = capture_reader_record_end (reader, offset)) > 0) {
+    g_array_append_val (reader->offsets, offset);
+    offset = end;
+  }
+
+  return reader;
+}
+
+void
+capture_reader_free (CaptureReader * reader)
+{
+  g_mapped_file_unref (reader->file);
+  g_array_free (reader->offsets, TRUE);
+  g_slice_free (CaptureReader, reader);
+}
+
+guint
+capture_reader_get_n_records (CaptureReader * reader)
+{
+  return reader->offsets->len;
+}
+
+void
+capture_reader_get_record (CaptureReader * reader, guint index,
+    CaptureRecord * record)
+{
+  const guint8 *data;
+
+  g_return_if_fail (index < reader->offsets->len);
+
+  data = reader->data + g_array_index (reader->offsets, guint64, index);
+  record->time = capture_get_u64 (data);
+  record->size = capture_get_u32 (data + 8);
+  record->flags = capture_get_u32 (data + 12);
+  record->data = data + CAPTURE_RECORD_HEADER_SIZE;
+}
+
+/* the mapping the records point into, for buffers that wrap them */
+GMappedFile *
+capture_reader_get_file (CaptureReader * reader)
+{
+  return reader->file;
+}
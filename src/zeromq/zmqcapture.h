@@ -0,0 +1,89 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __ZMQ_CAPTURE_H__
+#define __ZMQ_CAPTURE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Capture files, written by zmqrecord and read by zmqreplay. A capture is
+ * only ever appended to: a file header followed by one record per received
+ * message part, all numbers big endian.
+ *
+ *   file header (32 bytes)
+ *     magic          "GSTZMQCA"
+ *     version        u32
+ *     header_size    u32, of the file header
+ *     start_time     u64, wall clock time recording started, ns since epoch
+ *     reserved       u64
+ *
+ *   record (16 bytes, then the payload padded to a multiple of 8 bytes)
+ *     time           u64, arrival time, ns since recording started
+ *     size           u32, of the payload
+ *     flags          u32, CaptureRecordFlags
+ *
+ * Next to it, "<capture>.idx" holds one 16 byte entry per record: the
+ * record's offset in the capture (u64) and its time (u64). Readers follow
+ * the index only while each entry is where the record before it ends, and
+ * scan the capture from the first one that is not; a capture cut short by
+ * a crash reads up to its last complete record.
+ */
+
+#define CAPTURE_MAGIC "GSTZMQCA"
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER_SIZE 32
+#define CAPTURE_RECORD_HEADER_SIZE 16
+#define CAPTURE_INDEX_ENTRY_SIZE 16
+#define CAPTURE_INDEX_SUFFIX ".idx"
+
+typedef enum {
+  CAPTURE_RECORD_MORE           = (1 << 0)  // more parts of the message follow
+} CaptureRecordFlags;
+
+typedef struct _CaptureWriter CaptureWriter;
+typedef struct _CaptureReader CaptureReader;
+typedef struct _CaptureRecord CaptureRecord;
+
+struct _CaptureRecord {
+  guint64 time;
+  guint32 flags;
+  const guint8 *data;           // into the mapped capture
+  gsize size;
+};
+
+CaptureWriter *capture_writer_new (const gchar * path, gboolean overwrite,
+    GError ** error);
+gboolean capture_writer_append (CaptureWriter * writer, guint64 time,
+    guint32 flags, const guint8 * data, gsize size, GError ** error);
+gboolean capture_writer_flush (CaptureWriter * writer, GError ** error);
+gboolean capture_writer_close (CaptureWriter * writer, GError ** error);
+
+CaptureReader *capture_reader_new (const gchar * path, GError ** error);
+void capture_reader_free (CaptureReader * reader);
+guint capture_reader_get_n_records (CaptureReader * reader);
+void capture_reader_get_record (CaptureReader * reader, guint index,
+    CaptureRecord * record);
+GMappedFile *capture_reader_get_file (CaptureReader * reader);
+
+G_END_DECLS
+
+#endif /* __ZMQ_CAPTURE_H__ */
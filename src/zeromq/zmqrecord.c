@@ -0,0 +1,264 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* zmqrecord: subscribes to a stream, as zmqsrc would, and appends every
+ * message exactly as it arrived, with its arrival time, to a capture file
+ * for zmqreplay. Stops on Ctrl-C, or after --duration or --count. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <signal.h>
+
+#include "gstzmq.h"
+#include "gstzmqframing.h"
+#include "zmqcapture.h"
+
+/* for the endpoint parsing shared with the elements, which logs nothing */
+GST_DEBUG_CATEGORY (zmq_debug);
+
+#define RECORD_POLL_MS 100
+#define RECORD_FLUSH_INTERVAL GST_SECOND
+
+static gchar *opt_endpoint = NULL;
+static gboolean opt_bind = FALSE;
+#ifdef HAVE_ZMQ_RADIO_DISH
+static gboolean opt_dish = FALSE;
+static gchar *opt_group = NULL;
+#endif
+static gdouble opt_duration = 0;
+static gint64 opt_count = 0;
+static gboolean opt_force = FALSE;
+
+static GOptionEntry entries[] = {
+  {"endpoint", 'e', 0, G_OPTION_ARG_STRING, &opt_endpoint,
+        "Comma separated endpoints to receive from (default: "
+        ZMQ_DEFAULT_ENDPOINT_CLIENT ")", "LIST"},
+  {"bind", 'b', 0, G_OPTION_ARG_NONE, &opt_bind,
+      "Bind to the endpoints instead of connecting", NULL},
+#ifdef HAVE_ZMQ_RADIO_DISH
+  {"dish", 0, 0, G_OPTION_ARG_NONE, &opt_dish,
+      "Receive on a DISH socket, for udp:// endpoints", NULL},
+  {"group", 'g', 0, G_OPTION_ARG_STRING, &opt_group,
+      "Group to join on a DISH socket (default: " ZMQ_DEFAULT_GROUP ")",
+      "GROUP"},
+#endif
+  {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &opt_duration,
+      "Stop after this many seconds", "SECONDS"},
+  {"count", 'n', 0, G_OPTION_ARG_INT64, &opt_count,
+      "Stop after this many messages", "COUNT"},
+  {"force", 'f', 0, G_OPTION_ARG_NONE, &opt_force,
+      "Overwrite an existing capture", NULL},
+  {NULL}
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+static void
+record_stop (int signum)
+{
+  stopping = 1;
+}
+
+static void *
+record_open_socket (void *context, gchar ** endpoints)
+{
+  void *socket;
+  int value, rc;
+  guint i;
+
+#ifdef HAVE_ZMQ_RADIO_DISH
+  if (opt_dish)
+    socket = zmq_socket (context, ZMQ_DISH);
+  else
+#endif
+    socket = zmq_socket (context, ZMQ_SUB);
+  if (!socket) {
+    g_printerr ("zmq_socket() failed: %s\n", zmq_strerror (errno));
+    return NULL;
+  }
+
+  /* keep everything; the disk is faster than the network */
+  value = 0;
+  rc = zmq_setsockopt (socket, ZMQ_RCVHWM, &value, sizeof (value));
+  value = RECORD_POLL_MS;
+  if (rc == 0)
+    rc = zmq_setsockopt (socket, ZMQ_RCVTIMEO, &value, sizeof (value));
+  value = 0;
+  if (rc == 0)
+    rc = zmq_setsockopt (socket, ZMQ_LINGER, &value, sizeof (value));
+  if (rc) {
+    g_printerr ("zmq_setsockopt() failed: %s\n", zmq_strerror (errno));
+    zmq_close (socket);
+    return NULL;
+  }
+
+  for (i = 0; endpoints[i]; i++) {
+    rc = opt_bind ? zmq_bind (socket, endpoints[i]) :
+        zmq_connect (socket, endpoints[i]);
+    if (rc) {
+      g_printerr ("%s to \"%s\" failed: %s\n", opt_bind ? "zmq_bind()" :
+          "zmq_connect()", endpoints[i], zmq_strerror (errno));
+      zmq_close (socket);
+      return NULL;
+    }
+  }
+
+#ifdef HAVE_ZMQ_RADIO_DISH
+  if (opt_dish)
+    rc = zmq_join (socket, opt_group ? opt_group : ZMQ_DEFAULT_GROUP);
+  else
+#endif
+    rc = zmq_setsockopt (socket, ZMQ_SUBSCRIBE, "", 0);
+  if (rc) {
+    g_printerr ("subscribing failed: %s\n", zmq_strerror (errno));
+    zmq_close (socket);
+    return NULL;
+  }
+
+  return socket;
+}
+
+static gboolean
+record (void *socket, CaptureWriter * writer)
+{
+  GError *error = NULL;
+  GstClockTime start, now, last_flush;
+  guint64 messages = 0, bytes = 0;
+  gboolean ok = TRUE;
+  zmq_msg_t msg;
+  int rc;
+
+  zmq_msg_init (&msg);
+
+  start = last_flush = gst_util_get_timestamp ();
+  while (!stopping) {
+    rc = zmq_msg_recv (&msg, socket, 0);
+    now = gst_util_get_timestamp ();
+
+    if (rc >= 0) {
+      if (!capture_writer_append (writer, now - start,
+              zmq_msg_more (&msg) ? CAPTURE_RECORD_MORE : 0,
+              zmq_msg_data (&msg), zmq_msg_size (&msg), &error)) {
+        ok = FALSE;
+        break;
+      }
+      messages++;
+      bytes += zmq_msg_size (&msg);
+    } else if (errno != EAGAIN && errno != EINTR) {
+      g_printerr ("zmq_msg_recv() failed: %s\n", zmq_strerror (errno));
+      ok = FALSE;
+      break;
+    }
+
+    /* a capture cut short by a crash stays readable up to here */
+    if (now - last_flush >= RECORD_FLUSH_INTERVAL) {
+      if (!capture_writer_flush (writer, &error)) {
+        ok = FALSE;
+        break;
+      }
+      last_flush = now;
+    }
+
+    if ((opt_count > 0 && messages >= (guint64) opt_count)
+        || (opt_duration > 0 && now - start >= opt_duration * GST_SECOND))
+      break;
+  }
+
+  zmq_msg_close (&msg);
+
+  if (error) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+  }
+
+  g_printerr ("recorded %" G_GUINT64_FORMAT " messages, %" G_GUINT64_FORMAT
+      " bytes in %.3f s\n", messages, bytes,
+      (gdouble) (gst_util_get_timestamp () - start) / GST_SECOND);
+
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  CaptureWriter *writer;
+  gchar **endpoints;
+  void *zmq_context, *socket;
+  gboolean ok = FALSE;
+
+  context = g_option_context_new ("CAPTURE - record a ZeroMQ stream");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (argc != 2) {
+    g_printerr ("need the capture file to write, see --help\n");
+    return 1;
+  }
+
+  /* blanks and duplicates are dropped, like the elements do */
+  endpoints = gst_zmq_endpoints_parse (opt_endpoint ? opt_endpoint :
+      ZMQ_DEFAULT_ENDPOINT_CLIENT);
+  if (!endpoints[0]) {
+    g_printerr ("need an endpoint to receive from\n");
+    g_strfreev (endpoints);
+    return 1;
+  }
+
+  writer = capture_writer_new (argv[1], opt_force, &error);
+  if (!writer) {
+    if (g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_EXIST))
+      g_printerr ("%s, use --force to overwrite it\n", error->message);
+    else
+      g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_strfreev (endpoints);
+    return 1;
+  }
+
+  signal (SIGINT, record_stop);
+  signal (SIGTERM, record_stop);
+
+  zmq_context = zmq_ctx_new ();
+  socket = record_open_socket (zmq_context, endpoints);
+  if (socket) {
+    ok = record (socket, writer);
+    zmq_close (socket);
+  }
+  zmq_ctx_destroy (zmq_context);
+  g_strfreev (endpoints);
+
+  if (!capture_writer_close (writer, &error)) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    ok = FALSE;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,361 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* zmqreplay: maps a capture written by zmqrecord and publishes its
+ * messages again through appsrc ! zmqsink, from one or more publishers
+ * at once, at the recorded pace, faster, or as fast as possible. The
+ * messages go out as they were recorded, framing headers included, so
+ * zmqsrc at the other end sees the original stream.
+ *
+ * zmqsink only sends single part messages, so the parts of a multipart
+ * message recorded from some other publisher are replayed as messages of
+ * their own, one after the other. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <signal.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#include "gstzmq.h"
+#include "gstzmqframing.h"
+#include "zmqcapture.h"
+
+#define REPLAY_DEFAULT_DELAY 1000
+#define REPLAY_EOS_TIMEOUT (10 * GST_SECOND)
+
+/* longest nap while pacing, so Ctrl-C is noticed */
+#define REPLAY_MAX_SLEEP (100 * G_TIME_SPAN_MILLISECOND)
+
+/* for the endpoint parsing shared with the elements, which logs nothing */
+GST_DEBUG_CATEGORY (zmq_debug);
+
+typedef struct _Publisher Publisher;
+
+struct _Publisher {
+  guint id;
+  CaptureReader *reader;
+  GstElement *pipeline;
+  GstElement *appsrc;
+  GThread *thread;
+
+  guint64 messages;
+  guint64 bytes;
+  gint64 elapsed;
+  GstFlowReturn ret;
+};
+
+static gchar *opt_endpoint = NULL;
+static gboolean opt_connect = FALSE;
+static gint opt_publishers = 1;
+static gdouble opt_speed = 1.0;
+static gint opt_loops = 1;
+static gint opt_delay = REPLAY_DEFAULT_DELAY;
+
+static GOptionEntry entries[] = {
+  {"endpoint", 'e', 0, G_OPTION_ARG_STRING, &opt_endpoint,
+        "Comma separated endpoints to publish on, publisher n taking the "
+        "n-th one, round robin (default: " ZMQ_DEFAULT_ENDPOINT_SERVER ")",
+      "LIST"},
+  {"connect", 'c', 0, G_OPTION_ARG_NONE, &opt_connect,
+      "Connect to the endpoints instead of binding", NULL},
+  {"publishers", 'P', 0, G_OPTION_ARG_INT, &opt_publishers,
+      "Number of publishers, each replaying the whole capture", "N"},
+  {"speed", 's', 0, G_OPTION_ARG_DOUBLE, &opt_speed,
+      "Replay this many times faster than recorded (0 = as fast as "
+        "possible)", "FACTOR"},
+  {"loops", 'l', 0, G_OPTION_ARG_INT, &opt_loops,
+      "Replay the capture this many times (0 = until interrupted)", "N"},
+  {"delay", 0, 0, G_OPTION_ARG_INT, &opt_delay,
+      "Wait this many ms for subscribers before replaying", "MS"},
+  {NULL}
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+static void
+replay_stop (int signum)
+{
+  stopping = 1;
+}
+
+/* waits until @target, in monotonic time */
+static void
+replay_sleep_until (gint64 target)
+{
+  gint64 now;
+
+  while (!stopping && (now = g_get_monotonic_time ()) < target)
+    g_usleep (MIN (target - now, REPLAY_MAX_SLEEP));
+}
+
+/* the number of multipart messages in the capture */
+static guint
+replay_count_parts (CaptureReader * reader)
+{
+  CaptureRecord record;
+  guint n = capture_reader_get_n_records (reader), i, count = 0;
+  gboolean more = FALSE;
+
+  for (i = 0; i < n; i++) {
+    capture_reader_get_record (reader, i, &record);
+    if ((record.flags & CAPTURE_RECORD_MORE) && !more)
+      count++;
+    more = (record.flags & CAPTURE_RECORD_MORE) != 0;
+  }
+
+  return count;
+}
+
+static gpointer
+replay_publish (Publisher * publisher)
+{
+  GstAppSrc *appsrc = GST_APP_SRC (publisher->appsrc);
+  GMappedFile *file = capture_reader_get_file (publisher->reader);
+  guint n = capture_reader_get_n_records (publisher->reader);
+  CaptureRecord record;
+  GstBuffer *buffer;
+  gint64 start, loop_start;
+  guint64 first = 0;
+  guint loop, i;
+
+  publisher->ret = GST_FLOW_OK;
+  start = g_get_monotonic_time ();
+
+  for (loop = 0; (opt_loops == 0 || loop < (guint) opt_loops)
+      && publisher->ret == GST_FLOW_OK && !stopping; loop++) {
+    loop_start = g_get_monotonic_time ();
+
+    for (i = 0; i < n && publisher->ret == GST_FLOW_OK && !stopping; i++) {
+      capture_reader_get_record (publisher->reader, i, &record);
+      if (i == 0)
+        first = record.time;
+
+      if (opt_speed > 0)
+        replay_sleep_until (loop_start +
+            (gint64) ((record.time - first) / GST_USECOND / opt_speed));
+
+      /* the buffers point into the mapped capture, which they keep
+       * alive for as long as zmqsink holds on to them */
+      if (record.size == 0)
+        buffer = gst_buffer_new ();
+      else
+        buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+            (gpointer) record.data, record.size, 0, record.size,
+            g_mapped_file_ref (file), (GDestroyNotify) g_mapped_file_unref);
+
+      publisher->ret = gst_app_src_push_buffer (appsrc, buffer);
+      publisher->messages++;
+      publisher->bytes += record.size;
+    }
+  }
+
+  publisher->elapsed = MAX (g_get_monotonic_time () - start, 1);
+  gst_app_src_end_of_stream (appsrc);
+
+  return NULL;
+}
+
+static gboolean
+replay_create (Publisher * publisher, const gchar * endpoint)
+{
+  GError *error = NULL;
+  gchar *description;
+
+  description = g_strdup_printf ("appsrc name=appsrc block=true "
+      "format=bytes ! zmqsink endpoint=%s bind=%s sync=false "
+      "async=false", endpoint, opt_connect ? "false" : "true");
+  publisher->pipeline = gst_parse_launch (description, &error);
+  g_free (description);
+
+  if (!publisher->pipeline) {
+    g_printerr ("could not create publisher %u: %s\n", publisher->id,
+        error->message);
+    g_clear_error (&error);
+    return FALSE;
+  }
+  g_clear_error (&error);
+
+  publisher->appsrc = gst_bin_get_by_name (GST_BIN (publisher->pipeline),
+      "appsrc");
+
+  return TRUE;
+}
+
+/* waits for the last buffers to go out, reports errors and prints what
+ * the publisher sent */
+static gboolean
+replay_finish (Publisher * publisher)
+{
+  GstBus *bus = gst_element_get_bus (publisher->pipeline);
+  GstMessage *msg;
+  gdouble seconds = (gdouble) publisher->elapsed / G_TIME_SPAN_SECOND;
+  gboolean ok = publisher->ret == GST_FLOW_OK;
+
+  msg = gst_bus_timed_pop_filtered (bus, REPLAY_EOS_TIMEOUT,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *error = NULL;
+    gchar *debug = NULL;
+
+    gst_message_parse_error (msg, &error, &debug);
+    g_printerr ("publisher %u: error from %s: %s\n%s\n", publisher->id,
+        GST_OBJECT_NAME (msg->src), error->message, debug ? debug : "");
+    g_clear_error (&error);
+    g_free (debug);
+    ok = FALSE;
+  }
+  if (msg)
+    gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  g_print ("publisher %u: %" G_GUINT64_FORMAT " messages, %" G_GUINT64_FORMAT
+      " bytes in %.3f s (%.1f msgs/s, %.3f MB/s)\n", publisher->id,
+      publisher->messages, publisher->bytes, seconds,
+      publisher->messages / seconds, publisher->bytes / seconds / 1e6);
+
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GstElementFactory *factory;
+  GError *error = NULL;
+  CaptureReader *reader;
+  Publisher *publishers;
+  gchar **endpoints;
+  guint n_endpoints, multipart, i;
+  gboolean ok = TRUE;
+
+  context = g_option_context_new ("CAPTURE - replay a recorded ZeroMQ "
+      "stream");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (argc != 2) {
+    g_printerr ("need the capture file to replay, see --help\n");
+    return 1;
+  }
+
+  if (opt_publishers <= 0 || opt_speed < 0 || opt_loops < 0
+      || opt_delay < 0) {
+    g_printerr ("need at least one publisher, and a speed, loop count and "
+        "delay of 0 or more\n");
+    return 1;
+  }
+
+  /* any version will do, the plugin is versioned with the tree, not with
+   * GStreamer */
+  factory = gst_element_factory_find ("zmqsink");
+  if (!factory) {
+    g_printerr ("the zmq plugin was not found, set GST_PLUGIN_PATH\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  /* blanks and duplicates are dropped, like the elements do */
+  endpoints = gst_zmq_endpoints_parse (opt_endpoint ? opt_endpoint :
+      ZMQ_DEFAULT_ENDPOINT_SERVER);
+  n_endpoints = g_strv_length (endpoints);
+  if (n_endpoints == 0) {
+    g_printerr ("need an endpoint to publish on\n");
+    g_strfreev (endpoints);
+    return 1;
+  }
+
+  /* only one publisher can bind each endpoint */
+  if (!opt_connect && (guint) opt_publishers > n_endpoints) {
+    g_printerr ("%d binding publishers need as many endpoints, or use "
+        "--connect\n", opt_publishers);
+    g_strfreev (endpoints);
+    return 1;
+  }
+
+  reader = capture_reader_new (argv[1], &error);
+  if (!reader) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_strfreev (endpoints);
+    return 1;
+  }
+
+  g_printerr ("replaying %u messages from %s\n",
+      capture_reader_get_n_records (reader), argv[1]);
+  multipart = replay_count_parts (reader);
+  if (multipart > 0)
+    g_printerr ("%u messages have several parts, their parts go out as "
+        "messages of their own\n", multipart);
+
+  publishers = g_new0 (Publisher, opt_publishers);
+  for (i = 0; ok && i < (guint) opt_publishers; i++) {
+    publishers[i].id = i;
+    publishers[i].reader = reader;
+    ok = replay_create (&publishers[i], endpoints[i % n_endpoints]);
+    if (ok && gst_element_set_state (publishers[i].pipeline,
+            GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+      g_printerr ("could not start publisher %u on %s\n", i,
+          endpoints[i % n_endpoints]);
+      ok = FALSE;
+    }
+  }
+
+  if (ok) {
+    signal (SIGINT, replay_stop);
+    signal (SIGTERM, replay_stop);
+
+    /* PUB drops what it sends before subscribers are connected */
+    replay_sleep_until (g_get_monotonic_time () +
+        opt_delay * G_TIME_SPAN_MILLISECOND);
+
+    for (i = 0; i < (guint) opt_publishers; i++)
+      publishers[i].thread = g_thread_new ("replay",
+          (GThreadFunc) replay_publish, &publishers[i]);
+
+    for (i = 0; i < (guint) opt_publishers; i++) {
+      g_thread_join (publishers[i].thread);
+      ok = replay_finish (&publishers[i]) && ok;
+    }
+  }
+
+  for (i = 0; i < (guint) opt_publishers; i++) {
+    if (!publishers[i].pipeline)
+      continue;
+    gst_element_set_state (publishers[i].pipeline, GST_STATE_NULL);
+    gst_object_unref (publishers[i].appsrc);
+    gst_object_unref (publishers[i].pipeline);
+  }
+  g_free (publishers);
+
+  capture_reader_free (reader);
+  g_strfreev (endpoints);
+
+  return ok ? 0 : 1;
+}
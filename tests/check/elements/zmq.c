@@ -0,0 +1,701 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* zmqsink to zmqsrc over ipc://. inproc:// cannot be tested: every
+ * element creates a ZeroMQ context of its own, and inproc:// endpoints are
+ * only reachable within one context. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <unistd.h>             // for getpid
+
+#include <gst/check/gstcheck.h>
+#include <zmq.h>
+
+#include "gstzmq.h"
+
+#define CONNECT_TIMEOUT (5 * G_TIME_SPAN_SECOND)
+#define RECEIVE_TIMEOUT (5 * G_TIME_SPAN_SECOND)
+#define QUIET_TIME (100 * G_TIME_SPAN_MILLISECOND)
+
+/* a stop that waited for the pending receive to time out would take a
+ * whole receive timeout */
+#define STOP_TIMEOUT (ZMQ_RECEIVE_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND / 2)
+
+/* probes are the only one byte messages, payloads are longer */
+#define PROBE_SIZE 1
+
+#define ZERO_COPY_SIZE (8 * 1024 * 1024)
+#define ZERO_COPY_PAYLOADS 4
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static const gsize payload_sizes[] = {
+  2, 1000, ZMQ_ZERO_COPY_MIN_SIZE - 1, ZMQ_ZERO_COPY_MIN_SIZE,
+  1024 * 1024, 7 * 1024 * 1024 + 3
+};
+
+typedef struct
+{
+  GstElement *sink;             // zmqsink, fed from srcpad
+  GstElement *src;              // zmqsrc, feeding sinkpad
+  GstPad *srcpad;
+  GstPad *sinkpad;
+} Pair;
+
+static guint endpoint_count = 0;
+
+static gchar *
+new_endpoint (void)
+{
+  return g_strdup_printf ("ipc://%s/gst-zmq-check-%d-%u", g_get_tmp_dir (),
+      (int) getpid (), endpoint_count++);
+}
+
+/* runs of 64 equal bytes, so the payload compresses */
+static GstBuffer *
+new_payload (gsize size, guint seed)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < size; i++)
+    map.data[i] = (i / 64 + seed) & 0xff;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static gboolean
+have_compression (const gchar * nick)
+{
+  GstElement *sink = gst_element_factory_make ("zmqsink", NULL);
+  GParamSpec *pspec;
+  gboolean have;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (sink),
+      "compression");
+  have = g_enum_get_value_by_nick (G_PARAM_SPEC_ENUM (pspec)->enum_class,
+      nick) != NULL;
+  gst_object_unref (sink);
+
+  return have;
+}
+
+static const gchar *
+any_compression (void)
+{
+  if (have_compression ("lz4"))
+    return "lz4";
+  if (have_compression ("zstd"))
+    return "zstd";
+  return NULL;
+}
+
+/* buffers zmqsrc pushed so far, probes only counting if asked to; called
+ * with check_mutex held */
+static guint
+count_buffers (gboolean probes)
+{
+  GList *l;
+  guint n = 0;
+
+  for (l = buffers; l; l = l->next) {
+    if (probes || gst_buffer_get_size (GST_BUFFER (l->data)) != PROBE_SIZE)
+      n++;
+  }
+
+  return n;
+}
+
+static gboolean
+wait_for_buffers (guint n, gboolean probes, gint64 timeout)
+{
+  gint64 deadline = g_get_monotonic_time () + timeout;
+  gboolean arrived;
+
+  g_mutex_lock (&check_mutex);
+  while (count_buffers (probes) < n
+      && g_cond_wait_until (&check_cond, &check_mutex, deadline));
+  arrived = count_buffers (probes) >= n;
+  g_mutex_unlock (&check_mutex);
+
+  return arrived;
+}
+
+/* compares what zmqsrc pushed, probes left out, with the first @n of
+ * payload_sizes as made by new_payload() */
+static void
+check_payloads (guint n)
+{
+  GstBuffer *buf, *expected;
+  GstMapInfo map;
+  GList *l;
+  guint i = 0;
+
+  g_mutex_lock (&check_mutex);
+  for (l = buffers; l; l = l->next) {
+    buf = GST_BUFFER (l->data);
+    if (gst_buffer_get_size (buf) == PROBE_SIZE)
+      continue;
+
+    fail_unless (i < n, "more payloads arrived than were sent");
+    fail_unless_equals_uint64 (gst_buffer_get_size (buf), payload_sizes[i]);
+
+    expected = new_payload (payload_sizes[i], i + 1);
+    gst_buffer_map (expected, &map, GST_MAP_READ);
+    fail_unless (gst_buffer_memcmp (buf, 0, map.data, map.size) == 0,
+        "payload %u arrived corrupted", i);
+    gst_buffer_unmap (expected, &map);
+    gst_buffer_unref (expected);
+    i++;
+  }
+  g_mutex_unlock (&check_mutex);
+
+  fail_unless_equals_int (i, n);
+}
+
+static void
+push_stream_start (GstPad * srcpad)
+{
+  GstSegment segment;
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("zmq-check"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+}
+
+static void
+pair_setup (Pair * pair, guint stripes)
+{
+  gchar *endpoint = new_endpoint ();
+
+  pair->sink = gst_check_setup_element ("zmqsink");
+  g_object_set (pair->sink, "endpoint", endpoint, "stripes", stripes,
+      "sync", FALSE, "async", FALSE, NULL);
+  pair->srcpad = gst_check_setup_src_pad (pair->sink, &srctemplate);
+
+  pair->src = gst_check_setup_element ("zmqsrc");
+  g_object_set (pair->src, "endpoint", endpoint, "stripes", stripes, NULL);
+  pair->sinkpad = gst_check_setup_sink_pad (pair->src, &sinktemplate);
+
+  g_free (endpoint);
+}
+
+/* PUB drops what it sends before the subscription reached it, so send
+ * probes until one arrives, then forget about them */
+static void
+pair_connect (Pair * pair)
+{
+  gint64 deadline = g_get_monotonic_time () + CONNECT_TIMEOUT;
+  gboolean connected = FALSE;
+
+  while (!connected && g_get_monotonic_time () < deadline) {
+    fail_unless_equals_int (gst_pad_push (pair->srcpad,
+            new_payload (PROBE_SIZE, 0)), GST_FLOW_OK);
+    connected = wait_for_buffers (1, TRUE, 10 * G_TIME_SPAN_MILLISECOND);
+  }
+  fail_unless (connected, "no probe arrived");
+
+  g_usleep (QUIET_TIME);
+  gst_check_drop_buffers ();
+}
+
+static void
+pair_start (Pair * pair)
+{
+  gst_pad_set_active (pair->srcpad, TRUE);
+  gst_pad_set_active (pair->sinkpad, TRUE);
+
+  fail_unless_equals_int (gst_element_set_state (pair->sink,
+          GST_STATE_PLAYING), GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_element_set_state (pair->src, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  push_stream_start (pair->srcpad);
+  pair_connect (pair);
+}
+
+static void
+pair_stop (Pair * pair)
+{
+  fail_unless_equals_int (gst_element_set_state (pair->src, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (pair->sink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  gst_pad_set_active (pair->srcpad, FALSE);
+  gst_pad_set_active (pair->sinkpad, FALSE);
+  gst_check_drop_buffers ();
+}
+
+static void
+pair_teardown (Pair * pair)
+{
+  pair_stop (pair);
+
+  gst_check_teardown_src_pad (pair->sink);
+  gst_check_teardown_sink_pad (pair->src);
+  gst_check_teardown_element (pair->sink);
+  gst_check_teardown_element (pair->src);
+}
+
+static void
+push_payloads (Pair * pair, guint n)
+{
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    fail_unless_equals_int (gst_pad_push (pair->srcpad,
+            new_payload (payload_sizes[i], i + 1)), GST_FLOW_OK);
+  }
+
+  fail_unless (wait_for_buffers (n, FALSE, RECEIVE_TIMEOUT),
+      "only some payloads arrived");
+}
+
+static void
+run_payload_integrity (guint stripes, const gchar * compression)
+{
+  Pair pair;
+
+  pair_setup (&pair, stripes);
+  if (compression)
+    gst_util_set_object_arg (G_OBJECT (pair.sink), "compression", compression);
+  pair_start (&pair);
+
+  push_payloads (&pair, G_N_ELEMENTS (payload_sizes));
+  check_payloads (G_N_ELEMENTS (payload_sizes));
+
+  pair_teardown (&pair);
+}
+
+GST_START_TEST (test_payload_integrity)
+{
+  run_payload_integrity (1, NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_payload_integrity_striped)
+{
+  run_payload_integrity (3, NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_payload_integrity_compressed)
+{
+  run_payload_integrity (1, any_compression ());
+  run_payload_integrity (3, any_compression ());
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_state_cycling)
+{
+  Pair pair;
+  guint i;
+
+  pair_setup (&pair, 2);
+
+  for (i = 0; i < 3; i++) {
+    pair_start (&pair);
+    push_payloads (&pair, 2);
+    check_payloads (2);
+    pair_stop (&pair);
+  }
+
+  pair_start (&pair);
+  pair_teardown (&pair);
+}
+
+GST_END_TEST;
+
+/* libzmq only unbinds a wildcard by the address it resolved to; removing
+ * one while streaming must go through quietly, free the port it got and
+ * leave the rest alone */
+GST_START_TEST (test_remove_wildcard_endpoint)
+{
+  GstBus *bus = gst_bus_new ();
+  GstMessage *msg;
+  Pair pair;
+  void *context, *socket;
+  gchar *endpoint, *endpoints, *resolved = NULL;
+  gint64 deadline;
+  gboolean bound = FALSE;
+
+  pair_setup (&pair, 1);
+  gst_element_set_bus (pair.sink, bus);
+  g_object_get (pair.sink, "endpoint", &endpoint, NULL);
+  endpoints = g_strdup_printf ("%s,tcp://127.0.0.1:*", endpoint);
+  g_object_set (pair.sink, "endpoint", endpoints, "monitor", TRUE, NULL);
+  pair_start (&pair);
+
+  /* the other endpoint is ipc, so the tcp one is the wildcard */
+  while (resolved == NULL) {
+    const GstStructure *s;
+    const gchar *address;
+
+    msg = gst_bus_timed_pop_filtered (bus, CONNECT_TIMEOUT * GST_USECOND,
+        GST_MESSAGE_ELEMENT);
+    fail_unless (msg != NULL, "zmqsink did not report listening");
+    s = gst_message_get_structure (msg);
+    address = gst_structure_get_string (s, "endpoint");
+    if (gst_structure_has_name (s, "zmq-listening") && address &&
+        g_str_has_prefix (address, "tcp://"))
+      resolved = g_strdup (address);
+    gst_message_unref (msg);
+  }
+
+  /* set_property() applies the change, the port is released by libzmq's
+   * I/O thread shortly after */
+  g_object_set (pair.sink, "endpoint", endpoint, NULL);
+
+  context = zmq_ctx_new ();
+  socket = zmq_socket (context, ZMQ_PUB);
+  fail_unless (socket != NULL);
+  deadline = g_get_monotonic_time () + CONNECT_TIMEOUT;
+  while (!bound && g_get_monotonic_time () < deadline) {
+    bound = zmq_bind (socket, resolved) == 0;
+    if (!bound)
+      g_usleep (QUIET_TIME / 10);
+  }
+  fail_unless (bound, "%s is still bound", resolved);
+  zmq_close (socket);
+  zmq_ctx_destroy (context);
+
+  push_payloads (&pair, 1);
+  check_payloads (1);
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_WARNING | GST_MESSAGE_ERROR);
+  fail_unless (msg == NULL, "removing the wildcard endpoint was reported");
+
+  pair_teardown (&pair);
+  gst_object_unref (bus);
+  g_free (resolved);
+  g_free (endpoints);
+  g_free (endpoint);
+}
+
+GST_END_TEST;
+
+/* zmqsink hands large single-memory buffers to ZeroMQ as they are. A
+ * subscriber that leaves all but one message on the wire keeps the last
+ * payloads queued in zmqsink's socket: sent zero-copy they are still
+ * referenced once pushed, copied they would not be. */
+GST_START_TEST (test_zero_copy_send)
+{
+  GstBuffer *payloads[ZERO_COPY_PAYLOADS];
+  GstElement *sink;
+  GstPad *srcpad;
+  zmq_msg_t msg;
+  void *context, *socket;
+  gchar *endpoint, probe;
+  gint64 deadline;
+  gboolean connected = FALSE;
+  int hwm = 1, timeout = 10;
+  guint i;
+
+  endpoint = new_endpoint ();
+  sink = gst_check_setup_element ("zmqsink");
+  g_object_set (sink, "endpoint", endpoint, "sync", FALSE, "async", FALSE,
+      NULL);
+  srcpad = gst_check_setup_src_pad (sink, &srctemplate);
+  gst_pad_set_active (srcpad, TRUE);
+  fail_unless_equals_int (gst_element_set_state (sink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+  push_stream_start (srcpad);
+
+  context = zmq_ctx_new ();
+  socket = zmq_socket (context, ZMQ_SUB);
+  fail_unless (socket != NULL);
+  fail_unless_equals_int (zmq_setsockopt (socket, ZMQ_RCVHWM, &hwm,
+          sizeof (hwm)), 0);
+  fail_unless_equals_int (zmq_setsockopt (socket, ZMQ_RCVTIMEO, &timeout,
+          sizeof (timeout)), 0);
+  fail_unless_equals_int (zmq_setsockopt (socket, ZMQ_SUBSCRIBE, "", 0), 0);
+  fail_unless_equals_int (zmq_connect (socket, endpoint), 0);
+  g_free (endpoint);
+
+  deadline = g_get_monotonic_time () + CONNECT_TIMEOUT;
+  while (!connected && g_get_monotonic_time () < deadline) {
+    fail_unless_equals_int (gst_pad_push (srcpad, new_payload (PROBE_SIZE,
+                0)), GST_FLOW_OK);
+    connected = zmq_recv (socket, &probe, 1, 0) == PROBE_SIZE;
+  }
+  fail_unless (connected, "no probe arrived");
+  g_usleep (QUIET_TIME);
+  while (zmq_recv (socket, &probe, 1, ZMQ_DONTWAIT) >= 0);
+
+  for (i = 0; i < ZERO_COPY_PAYLOADS; i++) {
+    payloads[i] = new_payload (ZERO_COPY_SIZE, i + 1);
+    fail_unless_equals_int (gst_pad_push (srcpad,
+            gst_buffer_ref (payloads[i])), GST_FLOW_OK);
+  }
+  fail_unless (GST_MINI_OBJECT_REFCOUNT_VALUE (payloads[ZERO_COPY_PAYLOADS -
+              1]) > 1, "the payload was copied");
+
+  timeout = RECEIVE_TIMEOUT / G_TIME_SPAN_MILLISECOND;
+  fail_unless_equals_int (zmq_setsockopt (socket, ZMQ_RCVTIMEO, &timeout,
+          sizeof (timeout)), 0);
+  for (i = 0; i < ZERO_COPY_PAYLOADS; i++) {
+    fail_unless_equals_int (zmq_msg_init (&msg), 0);
+    fail_unless_equals_int (zmq_msg_recv (&msg, socket, 0), ZERO_COPY_SIZE);
+    fail_unless (gst_buffer_memcmp (payloads[i], 0, zmq_msg_data (&msg),
+            ZERO_COPY_SIZE) == 0, "payload %u arrived corrupted", i);
+    zmq_msg_close (&msg);
+  }
+
+  /* ZeroMQ lets go of each buffer once it is sent */
+  deadline = g_get_monotonic_time () + RECEIVE_TIMEOUT;
+  for (i = 0; i < ZERO_COPY_PAYLOADS; i++) {
+    while (GST_MINI_OBJECT_REFCOUNT_VALUE (payloads[i]) > 1
+        && g_get_monotonic_time () < deadline)
+      g_usleep (G_TIME_SPAN_MILLISECOND);
+    ASSERT_MINI_OBJECT_REFCOUNT (payloads[i], "payload", 1);
+    gst_buffer_unref (payloads[i]);
+  }
+
+  zmq_close (socket);
+  zmq_ctx_term (context);
+
+  fail_unless_equals_int (gst_element_set_state (sink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_check_teardown_src_pad (sink);
+  gst_check_teardown_element (sink);
+}
+
+GST_END_TEST;
+
+/* unlock() interrupts the receive rather than waiting it out */
+GST_START_TEST (test_stop_while_silent)
+{
+  Pair pair;
+  gint64 start, elapsed;
+
+  pair_setup (&pair, 1);
+  pair_start (&pair);
+
+  /* zmqsrc is waiting for a message that is not coming */
+  g_usleep (QUIET_TIME);
+
+  start = g_get_monotonic_time ();
+  fail_unless_equals_int (gst_element_set_state (pair.src, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  elapsed = g_get_monotonic_time () - start;
+  fail_unless (elapsed < STOP_TIMEOUT, "stopping took %" G_GINT64_FORMAT
+      " us", elapsed);
+
+  pair_teardown (&pair);
+}
+
+GST_END_TEST;
+
+/* an allocator handing out system memory that counts how often it does */
+typedef struct
+{
+  GstAllocator parent;
+} CountingAllocator;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} CountingAllocatorClass;
+
+GType counting_allocator_get_type (void);
+G_DEFINE_TYPE (CountingAllocator, counting_allocator, GST_TYPE_ALLOCATOR);
+
+static gint allocations = 0;
+
+static GstMemory *
+counting_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  g_atomic_int_inc (&allocations);
+
+  return gst_allocator_alloc (NULL, size, params);
+}
+
+static void
+counting_allocator_free (GstAllocator * allocator, GstMemory * memory)
+{
+  /* the memory belongs to the system allocator */
+  g_assert_not_reached ();
+}
+
+static void
+counting_allocator_class_init (CountingAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = GST_ALLOCATOR_CLASS (klass);
+
+  allocator_class->alloc = counting_allocator_alloc;
+  allocator_class->free = counting_allocator_free;
+}
+
+static void
+counting_allocator_init (CountingAllocator * allocator)
+{
+}
+
+static GstAllocator *counting_allocator = NULL;
+
+static gboolean
+propose_counting_allocator (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION) {
+    gst_query_add_allocation_param (query, counting_allocator, NULL);
+    return TRUE;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+/* every pushed buffer is allocated once, reassembled and decompressed
+ * payloads included; received data never goes through a second buffer */
+static void
+run_allocations_per_message (guint stripes, const gchar * compression)
+{
+  Pair pair;
+  guint delivered;
+
+  counting_allocator = g_object_new (counting_allocator_get_type (), NULL);
+
+  pair_setup (&pair, stripes);
+  if (compression)
+    gst_util_set_object_arg (G_OBJECT (pair.sink), "compression", compression);
+  gst_pad_set_query_function (pair.sinkpad, propose_counting_allocator);
+  pair_start (&pair);
+
+  g_atomic_int_set (&allocations, 0);
+  push_payloads (&pair, G_N_ELEMENTS (payload_sizes));
+  check_payloads (G_N_ELEMENTS (payload_sizes));
+
+  /* probes late for pair_connect() were allocated too */
+  g_mutex_lock (&check_mutex);
+  delivered = count_buffers (TRUE);
+  g_mutex_unlock (&check_mutex);
+  fail_unless (g_atomic_int_get (&allocations) <= delivered,
+      "%d allocations for %u buffers", g_atomic_int_get (&allocations),
+      delivered);
+
+  pair_teardown (&pair);
+  gst_object_unref (counting_allocator);
+  counting_allocator = NULL;
+}
+
+GST_START_TEST (test_allocations_per_message)
+{
+  run_allocations_per_message (1, NULL);
+  run_allocations_per_message (3, NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_allocations_per_message_compressed)
+{
+  run_allocations_per_message (1, any_compression ());
+  run_allocations_per_message (3, any_compression ());
+}
+
+GST_END_TEST;
+
+static void
+finalized (gpointer data, GObject * where_the_object_was)
+{
+  *(gboolean *) data = TRUE;
+}
+
+/* nothing the elements create while streaming keeps them, or the buffer
+ * pool zmqsrc received into, alive after the last unref */
+GST_START_TEST (test_finalize)
+{
+  Pair pair;
+  GstBufferPool *pool;
+  gboolean sink_finalized = FALSE, src_finalized = FALSE;
+  gboolean pool_finalized = FALSE;
+
+  pair_setup (&pair, 2);
+  g_object_set (pair.sink, "monitor", TRUE, NULL);
+  g_object_set (pair.src, "monitor", TRUE, "max-message-size",
+      (guint) payload_sizes[3], NULL);
+  g_object_weak_ref (G_OBJECT (pair.sink), finalized, &sink_finalized);
+  g_object_weak_ref (G_OBJECT (pair.src), finalized, &src_finalized);
+  pair_start (&pair);
+
+  push_payloads (&pair, 4);
+  check_payloads (4);
+
+  g_mutex_lock (&check_mutex);
+  pool = GST_BUFFER (g_list_last (buffers)->data)->pool;
+  fail_unless (pool != NULL, "zmqsrc did not receive into a pool");
+  g_object_weak_ref (G_OBJECT (pool), finalized, &pool_finalized);
+  g_mutex_unlock (&check_mutex);
+
+  pair_teardown (&pair);
+
+  fail_unless (sink_finalized, "zmqsink was not finalized");
+  fail_unless (src_finalized, "zmqsrc was not finalized");
+  fail_unless (pool_finalized, "the buffer pool was not finalized");
+}
+
+GST_END_TEST;
+
+static Suite *
+zmq_suite (void)
+{
+  Suite *s = suite_create ("zmq");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
+
+  tcase_add_test (tc_chain, test_payload_integrity);
+  tcase_add_test (tc_chain, test_payload_integrity_striped);
+  tcase_add_test (tc_chain, test_state_cycling);
+  tcase_add_test (tc_chain, test_remove_wildcard_endpoint);
+  tcase_add_test (tc_chain, test_zero_copy_send);
+  tcase_add_test (tc_chain, test_stop_while_silent);
+  tcase_add_test (tc_chain, test_allocations_per_message);
+  tcase_add_test (tc_chain, test_finalize);
+
+  /* compression is only there when liblz4 or libzstd was found */
+  if (any_compression ()) {
+    tcase_add_test (tc_chain, test_payload_integrity_compressed);
+    tcase_add_test (tc_chain, test_allocations_per_message_compressed);
+  }
+
+  return s;
+}
+
+GST_CHECK_MAIN (zmq);
@@ -0,0 +1,241 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Capture files written by zmqrecord and read back the way zmqreplay does,
+ * including captures and indexes cut short by a crash. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <unistd.h>             // for truncate
+
+#include <glib/gstdio.h>
+#include <gst/check/gstcheck.h>
+
+#include "zmqcapture.h"
+
+#define N_RECORDS 8
+
+/* records are padded to a multiple of 8 bytes */
+#define RECORD_SIZE(size) \
+  (CAPTURE_RECORD_HEADER_SIZE + (((size) + 7) & ~(gsize) 7))
+
+static gchar *dir;
+static gchar *path;
+static gchar *index_path;
+
+/* sizes that need padding and ones that do not, and an empty one */
+static gsize
+record_size (guint i)
+{
+  return i * 5;
+}
+
+static guint8
+record_byte (guint i, gsize j)
+{
+  return i * 31 + j;
+}
+
+/* where record @i starts in the capture */
+static goffset
+record_offset (guint i)
+{
+  goffset offset = CAPTURE_HEADER_SIZE;
+  guint j;
+
+  for (j = 0; j < i; j++)
+    offset += RECORD_SIZE (record_size (j));
+
+  return offset;
+}
+
+static void
+capture_setup (void)
+{
+  dir = g_dir_make_tmp ("gst-zmq-capture-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  path = g_build_filename (dir, "test.zcap", NULL);
+  index_path = g_strconcat (path, CAPTURE_INDEX_SUFFIX, NULL);
+}
+
+static void
+capture_teardown (void)
+{
+  g_unlink (index_path);
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (index_path);
+  g_free (path);
+  g_free (dir);
+}
+
+static void
+write_capture (void)
+{
+  GError *error = NULL;
+  CaptureWriter *writer;
+  guint8 data[N_RECORDS * 5];
+  gsize j;
+  guint i;
+
+  writer = capture_writer_new (path, TRUE, &error);
+  fail_unless (writer != NULL, "could not create the capture: %s",
+      error ? error->message : "");
+
+  for (i = 0; i < N_RECORDS; i++) {
+    for (j = 0; j < record_size (i); j++)
+      data[j] = record_byte (i, j);
+    fail_unless (capture_writer_append (writer, i * GST_MSECOND,
+            i % 2 ? CAPTURE_RECORD_MORE : 0, data, record_size (i), &error),
+        "could not append record %u: %s", i, error ? error->message : "");
+  }
+
+  fail_unless (capture_writer_close (writer, &error),
+      "could not close the capture: %s", error ? error->message : "");
+}
+
+/* the capture must read as exactly the first @n records written */
+static void
+check_capture (guint n)
+{
+  GError *error = NULL;
+  CaptureReader *reader;
+  CaptureRecord record;
+  gsize j;
+  guint i;
+
+  reader = capture_reader_new (path, &error);
+  fail_unless (reader != NULL, "could not read the capture: %s",
+      error ? error->message : "");
+  fail_unless_equals_int (capture_reader_get_n_records (reader), n);
+
+  for (i = 0; i < n; i++) {
+    capture_reader_get_record (reader, i, &record);
+    fail_unless_equals_uint64 (record.time, i * GST_MSECOND);
+    fail_unless_equals_int (record.flags, i % 2 ? CAPTURE_RECORD_MORE : 0);
+    fail_unless_equals_int (record.size, record_size (i));
+    for (j = 0; j < record.size; j++)
+      fail_unless_equals_int (record.data[j], record_byte (i, j));
+  }
+
+  capture_reader_free (reader);
+}
+
+static void
+cut (const gchar * file, goffset length)
+{
+  fail_unless (truncate (file, length) == 0, "could not truncate %s", file);
+}
+
+GST_START_TEST (test_capture_round_trip)
+{
+  write_capture ();
+  check_capture (N_RECORDS);
+
+  /* the same without the index, by scanning */
+  g_unlink (index_path);
+  check_capture (N_RECORDS);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_capture_cut_in_payload)
+{
+  write_capture ();
+
+  /* the index still lists the records that were cut off */
+  cut (path, record_offset (5) + CAPTURE_RECORD_HEADER_SIZE + 2);
+  check_capture (5);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_capture_cut_in_record_header)
+{
+  write_capture ();
+
+  cut (path, record_offset (6) + CAPTURE_RECORD_HEADER_SIZE / 2);
+  check_capture (6);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_capture_index_cut_in_entry)
+{
+  write_capture ();
+
+  /* the records the index lost are found by scanning */
+  cut (index_path, 3 * CAPTURE_INDEX_ENTRY_SIZE + 7);
+  check_capture (N_RECORDS);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_capture_both_cut)
+{
+  write_capture ();
+
+  cut (index_path, 2 * CAPTURE_INDEX_ENTRY_SIZE + 5);
+  cut (path, record_offset (4) + CAPTURE_RECORD_HEADER_SIZE + 1);
+  check_capture (4);
+
+  /* down to the file header */
+  cut (path, CAPTURE_HEADER_SIZE);
+  check_capture (0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_capture_exclusive)
+{
+  GError *error = NULL;
+
+  write_capture ();
+
+  /* an existing capture is only replaced when asked to */
+  fail_unless (capture_writer_new (path, FALSE, &error) == NULL);
+  fail_unless (g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_EXIST));
+  g_clear_error (&error);
+  check_capture (N_RECORDS);
+}
+
+GST_END_TEST;
+
+static Suite *
+capture_suite (void)
+{
+  Suite *s = suite_create ("capture");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, capture_setup, capture_teardown);
+
+  tcase_add_test (tc_chain, test_capture_round_trip);
+  tcase_add_test (tc_chain, test_capture_cut_in_payload);
+  tcase_add_test (tc_chain, test_capture_cut_in_record_header);
+  tcase_add_test (tc_chain, test_capture_index_cut_in_entry);
+  tcase_add_test (tc_chain, test_capture_both_cut);
+  tcase_add_test (tc_chain, test_capture_exclusive);
+
+  return s;
+}
+
+GST_CHECK_MAIN (capture);
@@ -0,0 +1,482 @@
+/* GStreamer
+ * Copyright (C) <2015> Mark J. Howell <m0ppy at hypgnosys dot org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The message header and fragment reassembly, fed the kind of input a
+ * hostile or broken peer could send. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include "gstzmqframing.h"
+
+GST_DEBUG_CATEGORY (zmq_debug);
+
+#define MAX_SIZE 1024
+#define SENDER_A 0x1234
+#define SENDER_B 0x5678
+
+static guint64 dropped;
+static guint decoded;
+
+static GstBuffer *
+alloc_buffer (gsize size, gpointer user_data)
+{
+  return gst_buffer_new_allocate (NULL, size, NULL);
+}
+
+/* stands in for decompression, the payload comes out as it went in */
+static GstBuffer *
+decode_buffer (const GstZmqHeader * header, const guint8 * data, gsize size,
+    gpointer user_data)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+
+  decoded++;
+  gst_buffer_fill (buffer, 0, data, size);
+
+  return buffer;
+}
+
+static void
+reassembly_init (GstZmqReassembly * reassembly, guint fragments)
+{
+  dropped = 0;
+  decoded = 0;
+  gst_zmq_reassembly_init (reassembly, alloc_buffer, decode_buffer, NULL,
+      fragments, MAX_SIZE, &dropped);
+}
+
+static const guint8 *
+payload (void)
+{
+  static guint8 data[MAX_SIZE];
+  guint i;
+
+  for (i = 0; i < MAX_SIZE; i++)
+    data[i] = i * 7 + 1;
+
+  return data;
+}
+
+/* pushes bytes [offset, offset + size) of payload() as a fragment */
+static GstBuffer *
+push (GstZmqReassembly * reassembly, guint32 sender, guint64 seqnum,
+    guint8 flags, guint64 total_size, guint64 offset, gsize size,
+    guint16 stripe)
+{
+  GstZmqHeader header = { 0, };
+
+  header.flags = GST_ZMQ_HEADER_FLAG_FRAGMENT | flags;
+  header.header_size = GST_ZMQ_HEADER_SIZE;
+  header.seqnum = seqnum;
+  header.total_size = total_size;
+  header.offset = offset;
+  header.raw_size = total_size;
+  header.sender = sender;
+  header.stripe = stripe;
+
+  return gst_zmq_reassembly_push (reassembly, &header, payload () + offset,
+      size);
+}
+
+static void
+check_payload (GstBuffer * buffer, gsize size)
+{
+  fail_unless (buffer != NULL, "the payload was not completed");
+  fail_unless_equals_int (gst_buffer_get_size (buffer), size);
+  fail_unless (gst_buffer_memcmp (buffer, 0, payload (), size) == 0,
+      "the payload was put together wrongly");
+  gst_buffer_unref (buffer);
+}
+
+static void
+write_header (guint8 * data, guint8 flags)
+{
+  GstZmqHeader header = { 0, };
+
+  header.flags = flags;
+  header.seqnum = 42;
+  header.total_size = 100;
+  header.sender = SENDER_A;
+  gst_zmq_header_write (&header, data);
+}
+
+GST_START_TEST (test_header_round_trip)
+{
+  guint8 data[GST_ZMQ_HEADER_SIZE + 8];
+  GstZmqHeader header = { 0, }, parsed;
+
+  header.flags = GST_ZMQ_HEADER_FLAG_STAMPED | GST_ZMQ_HEADER_FLAG_FRAGMENT
+      | GST_ZMQ_HEADER_FLAG_LZ4;
+  header.seqnum = G_GUINT64_CONSTANT (0x0102030405060708);
+  header.send_time = 12345;
+  header.total_size = 1000;
+  header.offset = 500;
+  header.raw_size = 4000;
+  header.sender = SENDER_B;
+  header.stripe = 3;
+  gst_zmq_header_write (&header, data);
+
+  fail_unless (gst_zmq_header_read (&parsed, data, sizeof (data)));
+  fail_unless_equals_int (parsed.flags, header.flags);
+  fail_unless_equals_int (parsed.header_size, GST_ZMQ_HEADER_SIZE);
+  fail_unless_equals_uint64 (parsed.seqnum, header.seqnum);
+  fail_unless_equals_uint64 (parsed.send_time, header.send_time);
+  fail_unless_equals_uint64 (parsed.total_size, header.total_size);
+  fail_unless_equals_uint64 (parsed.offset, header.offset);
+  fail_unless_equals_uint64 (parsed.raw_size, header.raw_size);
+  fail_unless_equals_int (parsed.sender, header.sender);
+  fail_unless_equals_int (parsed.stripe, header.stripe);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_header_rejects_flags)
+{
+  guint8 data[GST_ZMQ_HEADER_SIZE];
+  GstZmqHeader header;
+
+  /* zmqsink sends unflagged payloads without a header */
+  write_header (data, 0);
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+
+  write_header (data, GST_ZMQ_HEADER_FLAG_STAMPED | (1 << 7));
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+
+  write_header (data, GST_ZMQ_HEADER_FLAG_LZ4 | GST_ZMQ_HEADER_FLAG_ZSTD);
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+
+  write_header (data, GST_ZMQ_HEADER_FLAG_ZSTD);
+  fail_unless (gst_zmq_header_read (&header, data, sizeof (data)));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_header_rejects_magic_and_version)
+{
+  guint8 data[GST_ZMQ_HEADER_SIZE];
+  GstZmqHeader header;
+
+  write_header (data, GST_ZMQ_HEADER_FLAG_STAMPED);
+  data[0] ^= 0xff;
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+
+  write_header (data, GST_ZMQ_HEADER_FLAG_STAMPED);
+  data[4] = GST_ZMQ_HEADER_VERSION + 1;
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+
+  data[4] = GST_ZMQ_HEADER_VERSION - 1;
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_header_rejects_short)
+{
+  guint8 data[GST_ZMQ_HEADER_SIZE + 8];
+  GstZmqHeader header;
+
+  write_header (data, GST_ZMQ_HEADER_FLAG_STAMPED);
+  fail_if (gst_zmq_header_read (&header, data, GST_ZMQ_HEADER_SIZE - 1));
+  fail_if (gst_zmq_header_read (&header, data, 0));
+
+  /* a header claiming to be longer than the message or shorter than the
+   * fields read from it */
+  GST_WRITE_UINT16_BE (data + 6, GST_ZMQ_HEADER_SIZE + 9);
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+  GST_WRITE_UINT16_BE (data + 6, GST_ZMQ_HEADER_SIZE - 1);
+  fail_if (gst_zmq_header_read (&header, data, sizeof (data)));
+
+  /* a longer header from a later minor change is skipped over */
+  GST_WRITE_UINT16_BE (data + 6, GST_ZMQ_HEADER_SIZE + 8);
+  fail_unless (gst_zmq_header_read (&header, data, sizeof (data)));
+  fail_unless_equals_int (header.header_size, GST_ZMQ_HEADER_SIZE + 8);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_in_order)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 300, 0, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 300, 100, 100, 0) == NULL);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 1);
+  check_payload (push (&reassembly, SENDER_A, 1, 0, 300, 200, 100, 0), 300);
+
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 0);
+  fail_unless_equals_uint64 (dropped, 0);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_duplicate_fragment)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  /* counting the repeat would make 200 of 200 bytes */
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 0, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 0, 100, 0) == NULL);
+  check_payload (push (&reassembly, SENDER_A, 1, 0, 200, 100, 100, 0), 200);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_overlapping_fragment)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 0, 120, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 100, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 0, 200, 0) == NULL);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 1);
+  check_payload (push (&reassembly, SENDER_A, 1, 0, 200, 120, 80, 0), 200);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_rejects_out_of_range)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  /* none of these may start a payload, let alone write past it */
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 201, 0, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 150, 51, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, G_MAXUINT64 - 10, 20,
+          0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, MAX_SIZE + 1, 0, 100,
+          0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, G_MAXUINT64, 0, 100,
+          0) == NULL);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 0);
+
+  /* nor change the size of one already started */
+  fail_unless (push (&reassembly, SENDER_A, 2, 0, 200, 0, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 2, 0, 300, 100, 200, 0) == NULL);
+  check_payload (push (&reassembly, SENDER_A, 2, 0, 200, 100, 100, 0), 200);
+
+  fail_unless_equals_uint64 (dropped, 0);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_evicts_oldest)
+{
+  GstZmqReassembly reassembly;
+  guint i;
+
+  reassembly_init (&reassembly, 0);
+
+  /* one payload more than there are slots, each from a sender of its own
+   * so completing one does not give up on the others */
+  for (i = 0; i <= GST_ZMQ_REASSEMBLY_SLOTS; i++)
+    fail_unless (push (&reassembly, SENDER_A + i, 1, 0, 200, 0, 100,
+            0) == NULL);
+
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly),
+      GST_ZMQ_REASSEMBLY_SLOTS);
+  fail_unless_equals_uint64 (dropped, 1);
+
+  /* the first one started was given up on, its rest starts it over */
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 100, 100, 0) == NULL);
+  fail_unless_equals_uint64 (dropped, 2);
+
+  /* the second one was given up on to make room for that, the last one
+   * is still there */
+  fail_unless (push (&reassembly, SENDER_A + 1, 1, 0, 200, 100, 100,
+          0) == NULL);
+  fail_unless_equals_uint64 (dropped, 3);
+  check_payload (push (&reassembly, SENDER_A + GST_ZMQ_REASSEMBLY_SLOTS, 1, 0,
+          200, 100, 100, 0), 200);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_interleaved_senders)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  /* two senders that both happen to be at seqnum 7 */
+  fail_unless (push (&reassembly, SENDER_A, 7, 0, 300, 0, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_B, 7, 0, 200, 100, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 7, 0, 300, 200, 100, 0) == NULL);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 2);
+
+  check_payload (push (&reassembly, SENDER_B, 7, 0, 200, 0, 100, 0), 200);
+  check_payload (push (&reassembly, SENDER_A, 7, 0, 300, 100, 100, 0), 300);
+
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 0);
+  fail_unless_equals_uint64 (dropped, 0);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_drops_older_on_completion)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 200, 0, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_B, 1, 0, 200, 0, 100, 0) == NULL);
+  check_payload (push (&reassembly, SENDER_A, 2, 0, 100, 0, 100, 0), 100);
+
+  /* only the sender's own older payload is given up on */
+  fail_unless_equals_uint64 (dropped, 1);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 1);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_stripes)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 3);
+
+  /* two bytes over three stripes leave stripe 0 empty, which still has to
+   * arrive for the payload to be complete */
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 2, 0, 1, 1) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 2, 0, 1, 1) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 2, 1, 1, 2) == NULL);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 1);
+
+  /* neither a stripe out of range nor a repeated one counts */
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 2, 0, 0, 3) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 1, 0, 2, 0, 0, 2) == NULL);
+  fail_unless_equals_int (gst_zmq_reassembly_pending (&reassembly), 1);
+
+  check_payload (push (&reassembly, SENDER_A, 1, 0, 2, 0, 0, 0), 2);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reassembly_compressed)
+{
+  GstZmqReassembly reassembly;
+
+  reassembly_init (&reassembly, 0);
+
+  /* put together in staging memory, then decoded once */
+  fail_unless (push (&reassembly, SENDER_A, 1, GST_ZMQ_HEADER_FLAG_LZ4, 200,
+          100, 100, 0) == NULL);
+  fail_unless_equals_int (decoded, 0);
+  check_payload (push (&reassembly, SENDER_A, 1, GST_ZMQ_HEADER_FLAG_LZ4, 200,
+          0, 100, 0), 200);
+  fail_unless_equals_int (decoded, 1);
+
+  /* an uncompressed fragment cannot complete a compressed payload */
+  fail_unless (push (&reassembly, SENDER_A, 2, GST_ZMQ_HEADER_FLAG_LZ4, 200,
+          0, 100, 0) == NULL);
+  fail_unless (push (&reassembly, SENDER_A, 2, 0, 200, 100, 100, 0) == NULL);
+  fail_unless_equals_int (decoded, 1);
+
+  gst_zmq_reassembly_clear (&reassembly);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_stripe_endpoint)
+{
+  gchar *endpoint;
+
+  endpoint = gst_zmq_stripe_endpoint ("tcp://*:5556", 0);
+  fail_unless_equals_string (endpoint, "tcp://*:5556");
+  g_free (endpoint);
+
+  endpoint = gst_zmq_stripe_endpoint ("tcp://*:5556", 2);
+  fail_unless_equals_string (endpoint, "tcp://*:5558");
+  g_free (endpoint);
+
+  endpoint = gst_zmq_stripe_endpoint ("ipc:///tmp/stream", 1);
+  fail_unless_equals_string (endpoint, "ipc:///tmp/stream-1");
+  g_free (endpoint);
+
+  /* which is why a wildcard port is refused when striping */
+  fail_unless (gst_zmq_endpoint_has_wildcard_port ("tcp://127.0.0.1:*"));
+  fail_unless (gst_zmq_endpoint_has_wildcard_port ("tcp://*:*"));
+  fail_if (gst_zmq_endpoint_has_wildcard_port ("tcp://*:5556"));
+  fail_if (gst_zmq_endpoint_has_wildcard_port ("ipc:///tmp/stream"));
+}
+
+GST_END_TEST;
+
+static Suite *
+framing_suite (void)
+{
+  Suite *s = suite_create ("framing");
+  TCase *tc_header = tcase_create ("header");
+  TCase *tc_reassembly = tcase_create ("reassembly");
+  TCase *tc_endpoints = tcase_create ("endpoints");
+
+  GST_DEBUG_CATEGORY_INIT (zmq_debug, "zmq", 0, "ZeroMQ framing");
+
+  suite_add_tcase (s, tc_header);
+  tcase_add_test (tc_header, test_header_round_trip);
+  tcase_add_test (tc_header, test_header_rejects_flags);
+  tcase_add_test (tc_header, test_header_rejects_magic_and_version);
+  tcase_add_test (tc_header, test_header_rejects_short);
+
+  suite_add_tcase (s, tc_reassembly);
+  tcase_add_test (tc_reassembly, test_reassembly_in_order);
+  tcase_add_test (tc_reassembly, test_reassembly_duplicate_fragment);
+  tcase_add_test (tc_reassembly, test_reassembly_overlapping_fragment);
+  tcase_add_test (tc_reassembly, test_reassembly_rejects_out_of_range);
+  tcase_add_test (tc_reassembly, test_reassembly_evicts_oldest);
+  tcase_add_test (tc_reassembly, test_reassembly_interleaved_senders);
+  tcase_add_test (tc_reassembly, test_reassembly_drops_older_on_completion);
+  tcase_add_test (tc_reassembly, test_reassembly_stripes);
+  tcase_add_test (tc_reassembly, test_reassembly_compressed);
+
+  suite_add_tcase (s, tc_endpoints);
+  tcase_add_test (tc_endpoints, test_stripe_endpoint);
+
+  return s;
+}
+
+GST_CHECK_MAIN (framing);